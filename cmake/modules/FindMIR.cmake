@@ -0,0 +1,38 @@
+# Version 1.0
+# Public Domain
+# Written by Maxime SCHMITT <maxime.schmitt@etu.unistra.fr>
+
+#/////////////////////////////////////////////////////////////////////////////#
+#                                                                             #
+# Search for the MIR JIT compiler and its C to MIR compiler                   #
+# Call with find_package(MIR)                                                 #
+# The module defines:                                                         #
+#   - MIR_FOUND        - If MIR was found                                     #
+#   - MIR_INCLUDE_DIRS - the MIR include directories                          #
+#   - MIR_LIBRARIES    - the MIR library directories                          #
+#                                                                             #
+#/////////////////////////////////////////////////////////////////////////////#
+
+include(LibFindMacros)
+
+# Get hints about paths
+libfind_pkg_check_modules(MIR_PKGCONF mir)
+
+# Headers
+find_path(MIR_INCLUDE_DIR
+  NAMES "mir.h"
+  PATHS ${MIR_PKGCONF_INCLUDE_DIRS})
+
+find_path(MIR_C2MIR_INCLUDE_DIR
+  NAMES "c2mir.h"
+  PATHS ${MIR_PKGCONF_INCLUDE_DIRS}
+  PATH_SUFFIXES c2mir)
+
+# Library
+find_library(MIR_LIBRARY
+  NAMES mir
+  PATHS ${MIR_PKGCONF_LIBRARY_DIRS})
+
+set(MIR_PROCESS_LIBS MIR_LIBRARY)
+set(MIR_PROCESS_INCLUDES MIR_INCLUDE_DIR MIR_C2MIR_INCLUDE_DIR)
+libfind_process(MIR)
@@ -47,6 +47,18 @@ enum acr_dimension_type {
   acr_dimension_type_free_dim,
 };
 
+/**
+ * \brief The order in which the tiles of a static kernel can be computed
+ */
+enum acr_tile_schedule {
+  /** \brief One tile after the other */
+  acr_tile_schedule_sequential,
+  /** \brief No tile depends on another one, all in parallel */
+  acr_tile_schedule_parallel,
+  /** \brief The tiles of a diagonal in parallel, one diagonal after the other */
+  acr_tile_schedule_wavefront,
+};
+
 /**
  * \brief Upper and lower bound information for every dimensions in a loop
  */
@@ -358,6 +370,21 @@ void acr_openscop_get_monitoring_position_and_num(
     size_t *starting_position,
     size_t *num_monitoring_dim);
 
+/**
+ * \brief Get the schedule of the tiles of the monitoring dimensions
+ * \param[in] scop The OpenScop format of the kernel, with its accesses
+ * \param[in] first_monitor_dimension The dimension number of the first
+ * monitoring dimension
+ * \param[in] num_monitor_dims The total number of monitoring dimensions
+ * \param[in] grid_size The tiling size
+ * \return The schedule keeping the result of the sequential tile order
+ */
+enum acr_tile_schedule acr_osl_get_tile_schedule(
+    const osl_scop_p scop,
+    size_t first_monitor_dimension,
+    size_t num_monitor_dims,
+    size_t grid_size);
+
 #endif // __ACR_OPENSCOP_H
 
 /**
@@ -48,6 +48,7 @@
 #define _POSIX_C_SOURCE 200809L
 #include <acr/acr_runtime_code_generation.h>
 #include <acr/acr_runtime_data.h>
+#include <acr/acr_runtime_placement.h>
 #include <acr/acr_runtime_threads.h>
 #include <acr/acr_stats.h>
 #include <stdatomic.h>
@@ -0,0 +1,235 @@
+/*
+ * Copyright (C) 2016 Maxime Schmitt
+ *
+ * ACR is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ *
+ * \file acr_runtime_cache.h
+ * \brief Cache of previously generated kernel versions
+ *
+ * \defgroup runtime_cache
+ *
+ * @{
+ * \brief Reuse the code and the compiled functions of already seen grids
+ *
+ * Two grids giving the same alternative to every tile generate the same code,
+ * the cache compares the alternatives and not the raw monitored values.
+ *
+ */
+
+#ifndef __ACR_RUNTIME_CACHE_H
+#define __ACR_RUNTIME_CACHE_H
+
+#include <limits.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+/**
+ * \brief The initial value of a hash computed with ::acr_hash_bytes
+ */
+#define ACR_HASH_INIT UINT64_C(14695981039346656037)
+
+/**
+ * \brief Hash a buffer (FNV-1a)
+ * \param[in] hash The current hash value, ::ACR_HASH_INIT for a new hash.
+ * \param[in] bytes The buffer to hash.
+ * \param[in] size The size of the buffer in bytes.
+ * \return The new hash value.
+ */
+uint64_t acr_hash_bytes(uint64_t hash, const void *bytes, size_t size);
+
+/**
+ * \brief Release the compiled code a function belongs to
+ * \param[in] code_handle The handle of the code, a shared object or a JIT
+ *            context.
+ */
+typedef void (*acr_code_unload)(void *code_handle);
+
+/**
+ * \brief Unload a shared object opened with dlopen
+ * \param[in] dlhandle The shared object handle.
+ */
+void acr_unload_shared_object(void *dlhandle);
+
+/**
+ * \brief The compilers a version is compiled with
+ */
+enum acr_version_cache_tier {
+  /** \brief Fast compiler, its code runs until the optimized code is ready */
+  acr_version_tier_quick,
+  /** \brief Optimizing compiler */
+  acr_version_tier_optimized,
+  /** \brief The number of tiers */
+  acr_version_num_tiers,
+};
+
+/**
+ * \brief The code of a version compiled by one compiler
+ */
+struct acr_version_cache_code {
+  /** \brief The compiled code handle, NULL if not compiled yet */
+  void *handle;
+  /** \brief Releases handle */
+  acr_code_unload unload;
+  /** \brief The function inside of the compiled code */
+  void *function;
+};
+
+/**
+ * \brief The key of a tile whose value has no alternative
+ */
+#define ACR_VERSION_CACHE_NO_ALTERNATIVE UCHAR_MAX
+
+/**
+ * \brief A kernel version generated for a given monitoring grid
+ */
+struct acr_version_cache_entry {
+  /** \brief The hash of the key */
+  uint64_t hash;
+  /** \brief The alternative of each tile, NULL for an empty entry */
+  unsigned char *key;
+  /** \brief The generated C code */
+  char *generated_code;
+  /** \brief The code compiled by each compiler */
+  struct acr_version_cache_code compiled[acr_version_num_tiers];
+  /** \brief The number of function pool slots using this entry */
+  size_t users;
+  /** \brief The last time this entry was used */
+  uint64_t last_use;
+};
+
+/**
+ * \brief Bounded LRU cache of kernel versions shared by the runtime threads
+ */
+struct acr_version_cache {
+  /** \brief Protects every field of the cache and of its entries */
+  pthread_mutex_t mutex;
+  /** \brief The maximum number of entries */
+  size_t capacity;
+  /** \brief The size of the monitoring grid */
+  size_t monitor_size;
+  /** \brief The key of each monitored value */
+  unsigned char value_keys[UCHAR_MAX + 1];
+  /** \brief Logical clock used to find the least recently used entry */
+  uint64_t clock;
+  /** \brief The entries */
+  struct acr_version_cache_entry *entries;
+};
+
+/**
+ * \brief Initialize a version cache
+ * \param[out] cache The cache to initialize.
+ * \param[in] capacity The maximum number of entries.
+ * \param[in] monitor_size The size of the monitoring grid.
+ * \param[in] value_keys The alternative number of each monitored value, or
+ *            ::ACR_VERSION_CACHE_NO_ALTERNATIVE.
+ * \pre capacity must be greater than the number of users that can hold an
+ * entry at the same time.
+ */
+void acr_version_cache_init(
+    struct acr_version_cache *cache,
+    size_t capacity,
+    size_t monitor_size,
+    const unsigned char value_keys[UCHAR_MAX + 1]);
+
+/**
+ * \brief Free the cache and unload the compiled code it owns
+ * \param[in,out] cache The cache to free.
+ */
+void acr_version_cache_free(struct acr_version_cache *cache);
+
+/**
+ * \brief Find the version generated for a grid
+ * \param[in,out] cache The cache.
+ * \param[in] monitor_result The grid to look for.
+ * \retval NULL If no version was generated for a grid with the same
+ * alternatives.
+ * \return The entry of the grid. The caller is registered as a user and must
+ * call ::acr_version_cache_release when it does not need the entry anymore.
+ */
+struct acr_version_cache_entry* acr_version_cache_acquire(
+    struct acr_version_cache *cache,
+    const unsigned char *monitor_result);
+
+/**
+ * \brief Add a newly generated version to the cache
+ * \param[in,out] cache The cache.
+ * \param[in] monitor_result The grid used to generate the code.
+ * \param[in] generated_code The generated code.
+ * \retval NULL If every entry is in use. The version is then not cached and
+ * the caller owns the compiled code of the version.
+ * \return The entry of the grid. The caller is registered as a user and must
+ * call ::acr_version_cache_release when it does not need the entry anymore.
+ * \remark The least recently used entry without user is evicted if the cache
+ * is full.
+ */
+struct acr_version_cache_entry* acr_version_cache_insert(
+    struct acr_version_cache *cache,
+    const unsigned char *monitor_result,
+    const char *generated_code);
+
+/**
+ * \brief Unregister a user of an entry
+ * \param[in,out] cache The cache.
+ * \param[in,out] entry The entry. Does nothing if NULL.
+ */
+void acr_version_cache_release(
+    struct acr_version_cache *cache,
+    struct acr_version_cache_entry *entry);
+
+/**
+ * \brief Get the compiled function of an entry
+ * \param[in,out] cache The cache.
+ * \param[in] entry The entry. May be NULL for a version that is not cached.
+ * \param[in] tier The compiler of the function.
+ * \retval NULL If the entry is NULL or was not compiled yet.
+ * \return The compiled function.
+ */
+void* acr_version_cache_get_function(
+    struct acr_version_cache *cache,
+    struct acr_version_cache_entry *entry,
+    enum acr_version_cache_tier tier);
+
+/**
+ * \brief Give compiled code to an entry
+ * \param[in,out] cache The cache.
+ * \param[in,out] entry The entry.
+ * \param[in] tier The compiler of the code.
+ * \param[in] code_handle The compiled code handle, owned by the cache
+ *            afterwards.
+ * \param[in] unload_code Releases code_handle.
+ * \param[in] function The function inside of the compiled code.
+ * \return The function to use. If another thread compiled the entry first,
+ * code_handle is released and the function of the previous code is returned.
+ */
+void* acr_version_cache_set_function(
+    struct acr_version_cache *cache,
+    struct acr_version_cache_entry *entry,
+    enum acr_version_cache_tier tier,
+    void *code_handle,
+    acr_code_unload unload_code,
+    void *function);
+
+#endif // __ACR_RUNTIME_CACHE_H
+
+/**
+ *
+ * @}
+ *
+ */
@@ -35,6 +35,95 @@
 #include <acr/runtime_alternatives.h>
 #include <isl/set.h>
 
+/**
+ * \brief A rectangle of tiles sharing the same alternative
+ */
+struct acr_tile_rectangle {
+  /** \brief Set to false if no rectangle starts at this column */
+  bool is_open;
+  /** \brief The alternative of the tiles */
+  size_t alternative;
+  /** \brief The last column of the rectangle */
+  unsigned long last_column;
+  /** \brief The first row of the rectangle */
+  unsigned long first_row;
+};
+
+/**
+ * \brief Per thread buffers used to build the alternative domains
+ *
+ * The domains built for the previous grid are kept so that the next
+ * generation only has to move the tiles that changed of alternative.
+ */
+struct acr_cloog_generation_buffer {
+  /** \brief The domains given to CLooG, one per alternative */
+  isl_set **sets;
+  /** \brief The domains of the previous grid, one per alternative */
+  isl_set **previous_sets;
+  /** \brief The previous grid, NULL before the first generation */
+  unsigned char *previous_data;
+  /** \brief The tiles that changed of alternative since the previous grid */
+  size_t *changed_tiles;
+  /** \brief The rectangles still growing, indexed by their first column */
+  struct acr_tile_rectangle *open_rectangles;
+  /** \brief The rectangles growing on the next row */
+  struct acr_tile_rectangle *next_open_rectangles;
+  /** \brief The coordinates of the first tile of a rectangle */
+  unsigned long *first_tile;
+  /** \brief The coordinates of the last tile of a rectangle */
+  unsigned long *last_tile;
+};
+
+/**
+ * \brief Build the box covering a rectangle of tiles
+ * \param[in] space The space of the monitoring dimensions (consumed).
+ * \param[in] grid_size The tiling size.
+ * \param[in] first_tile The coordinates of the first tile of the box.
+ * \param[in] last_tile The coordinates of the last tile of the box.
+ * \return The box covering every tile between first_tile and last_tile.
+ */
+isl_set* acr_isl_set_tile_box(
+    isl_space *space,
+    size_t grid_size,
+    const unsigned long *first_tile,
+    const unsigned long *last_tile);
+
+/**
+ * \brief Allocate the generation buffer of a code generation thread
+ * \param[out] buffer The buffer to initialize
+ * \param[in] data_info The runtime data info
+ */
+void acr_cloog_generation_buffer_init(
+    struct acr_cloog_generation_buffer *buffer,
+    const struct acr_runtime_data *data_info);
+
+/**
+ * \brief Free the generation buffer of a code generation thread
+ * \param[in,out] buffer The buffer to free
+ * \param[in] data_info The runtime data info
+ */
+void acr_cloog_generation_buffer_free(
+    struct acr_cloog_generation_buffer *buffer,
+    const struct acr_runtime_data *data_info);
+
+/**
+ * \brief Build the domain of each alternative from the monitoring grid
+ *
+ * The tiles are merged into rectangles the first time. Afterwards only the
+ * tiles that changed of alternative since the previous call are moved, unless
+ * too many of them changed.
+ * \param[in] data_info The runtime data info
+ * \param[in] data The array representation of the alternative state to use.
+ * \param[in] thread_num The id of the thread that requested the generation.
+ * \param[in,out] buffer The buffer of the calling thread. The domain of each
+ *                alternative is stored in its sets field, the caller owns them.
+ */
+void acr_cloog_alternative_sets_from_monitor(
+    const struct acr_runtime_data *data_info,
+    const unsigned char *data,
+    size_t thread_num,
+    struct acr_cloog_generation_buffer *buffer);
+
 /**
  * \brief Generate an optimized code based on the current data observation using
  * CLooG.
@@ -42,7 +131,7 @@
  * \param[in] data_info The runtime data info
  * \param[in] data The array representation of the alternative state to use.
  * \param[in] thread_num The id of the thread that requested the generation.
- * \param[in] generation_buffer A buffer of size the number of alternatives
+ * \param[in,out] generation_buffer The buffer of the calling thread
  * \sa runtime_data
  */
 void acr_cloog_generate_alternative_code_from_input(
@@ -50,7 +139,7 @@ void acr_cloog_generate_alternative_code_from_input(
     const struct acr_runtime_data *data_info,
     const unsigned char *data,
     size_t thread_num,
-    isl_set **generation_buffer);
+    struct acr_cloog_generation_buffer *generation_buffer);
 
 /**
  * \brief Update the OpenScop used for code generation with current alternative.
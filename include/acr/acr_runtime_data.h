@@ -86,6 +86,15 @@ struct acr_runtime_data {
   size_t num_codegen_threads;
   /** \brief Number of compilation threads */
   size_t num_compile_threads;
+  /** \brief Number of threads sharing the monitoring work */
+  size_t num_monitor_threads;
+  /** \brief Number of kernel calls a TCC version must survive before it is
+   * compiled with the system compiler. 0 compiles with both at once */
+  size_t promotion_calls;
+  /** \brief Initial number of slots of the function pool */
+  size_t function_pool_size;
+  /** \brief Number of slots the function pool can grow to */
+  size_t function_pool_max_size;
   /** The prefix used during compilation */
   char *kernel_prefix;
   /** The CLooG state for each threads */
@@ -122,16 +131,48 @@ struct acr_runtime_data {
   char* function_prototype;
   /** A pointer to a function giving the alternative structure for each cell */
   struct runtime_alternative* (*alternative_from_val)(unsigned char);
-  /** The monitoring function pointer */
-  void (*monitoring_function)(unsigned char*);
+  /** The monitoring function pointer. It scans the tiles of the outermost
+   * monitor dimension in [first, last[ */
+  void (*monitoring_function)(unsigned char*, long first, long last);
   /** The initial function pointer */
   void *original_function;
   /** The number of compiler flags */
   size_t num_compiler_flags;
   /** The compiler flags */
   char ***compiler_flags;
+  /** The directory where compiled kernels are cached. NULL if disabled */
+  char *compile_cache_dir;
+  /** One compile server per compilation thread. NULL if disabled */
+  struct acr_compile_server *compile_servers;
+  /** Set to true once the kernel reports the tiles it modifies */
+  atomic_bool dirty_tracking;
+  /** For each index of the outermost monitor dimension, true if one of its
+   * tiles was modified since the last monitoring */
+  atomic_bool *dirty_outer_tiles;
+  /** The kernel only modifies the tiles it computes, from the incremental
+   * clause of the monitor pragma */
+  bool incremental_monitoring;
+  /** For each index of the outermost monitor dimension, true if the
+   * proposed alternative function computes one of its tiles. NULL if it
+   * computes every tile. Protected by alternative_function_mutex. */
+  const bool *proposed_computed_tiles;
+  /** Same as proposed_computed_tiles for the function the kernel runs, only
+   * used by the kernel thread */
+  const bool *kernel_computed_tiles;
   pthread_cond_t monitor_sleep_cond;
+  /** Protects the monitor thread sleep */
+  pthread_mutex_t monitor_sleep_mutex;
+  /** True while the monitor thread waits for a kernel call */
+  atomic_bool monitor_sleeping;
   pthread_cond_t coordinator_continue_cond;
+  /** Protects coordinator_wakeups */
+  pthread_mutex_t coordinator_continue_mutex;
+  /** The number of times the coordinator was woken up */
+  size_t coordinator_wakeups;
+  /** Protects the kernel wait for an alternative function */
+  pthread_mutex_t alternative_function_mutex;
+  /** Signaled when an alternative function is given to a waiting kernel */
+  pthread_cond_t alternative_function_cond;
 
   /** The monitoring data used by the current kernel */
   _Atomic (unsigned char*) current_monitoring_data;
@@ -144,6 +185,17 @@ struct acr_runtime_data {
   atomic_flag monitor_thread_continue;
   /** Kernel informations */
   struct acr_runtime_kernel_info *kernel_info;
+  /** The kernel records its call times only while this is set, that is
+   * while a function is evaluated */
+  atomic_bool time_kernel_calls;
+  /** The function run by the last timed kernel call */
+  _Atomic (void *) timed_function;
+  /** The number of consecutive timed calls of timed_function */
+  _Atomic (size_t) timed_function_calls;
+  /** The mean time spent inside of timed_function */
+  _Atomic (double) timed_function_time;
+  /** The mean time spent inside of the original kernel function */
+  _Atomic (double) original_function_time;
 #ifdef ACR_STATS_ENABLED
   struct acr_runtime_stats *acr_stats;
 #endif
@@ -170,6 +222,10 @@ enum acr_static_data_reduction_function {
 struct acr_runtime_data_static {
   /** \brief set as true if the not yet initialized */
   bool is_uninitialized;
+  /** \brief The kernel name, used to name its saved precision map */
+  const char *const name;
+  /** \brief The number of alternatives */
+  const size_t num_alternatives;
   /** \brief The array where all the generated functions pointer are stored */
   unsigned char *precision_array;
   /** \brief The number of monitoring dimensions */
@@ -180,14 +236,36 @@ struct acr_runtime_data_static {
   intmax_t (*min_max)[2];
   /** \brief The total size of the function array */
   size_t total_functions;
+  /** \brief The lower corner of each tile, in the tile scanning order */
+  intmax_t *tile_origins;
+  /** \brief The tiles sorted by wavefront, NULL until they are scanned */
+  size_t *tile_order;
+  /** \brief Where each wavefront starts in tile_order, plus the end */
+  size_t *wavefront_start;
+  /** \brief The number of wavefronts */
+  size_t num_wavefronts;
 };
 
 /**
  * \brief Free the data structure used by a static kernel
  * \param[in] static_data The targeted structure
+ *
+ * \remark The precision map is saved first when the *ACR_PRECISION_MAP_DIR*
+ * environment variable is set.
  */
 void free_acr_static_data(struct acr_runtime_data_static *static_data);
 
+/**
+ * \brief Spawn the compile servers of a kernel before the simulation starts
+ *
+ * The generated code calls it when the program is loaded, while the process
+ * is still small. The kernel takes these servers at its initialization.
+ *
+ * \remark You can use the *ACR_COMPILE_SERVER* environment variable to use
+ * another compile server executable. An empty value disables the servers.
+ */
+void acr_runtime_prespawn_compile_servers(void);
+
 /**
  * \brief Initialize threads specific fields
  * \param[in,out] data The structure where the fields needs to be initialized
@@ -240,6 +318,127 @@ size_t acr_runtime_get_num_monitor_dims(struct acr_runtime_data* data);
 unsigned long* acr_runtime_get_monitor_dims_upper_bounds(
     struct acr_runtime_data* data);
 
+/**
+ * \brief Tell the monitor that the data of a tile was modified
+ * \param[in,out] data The acr runtime data structure
+ * \param[in] tile_index The position of the tile in the monitoring grid,
+ * that is its row major index over the monitored dimensions
+ *
+ * Once this function or ::acr_runtime_mark_all_tiles_dirty was called, the
+ * monitor only scans again the tiles marked as dirty since its last scan and
+ * keeps the previous result for the other ones. The kernel must then report
+ * every tile it modifies, once it finished writing it. The kernels built
+ * with the incremental clause of the monitor pragma report their tiles
+ * through ::acr_runtime_mark_computed_tiles_dirty after each call.
+ *
+ * \remark The tiles are tracked per index of the outermost monitor dimension,
+ * marking a tile marks all the tiles sharing its outermost index.
+ * \remark An index outside of the grid marks every tile.
+ */
+void acr_runtime_mark_tile_dirty(
+    struct acr_runtime_data *data,
+    size_t tile_index);
+
+/**
+ * \brief Tell the monitor that the data of every tile was modified
+ * \param[in,out] data The acr runtime data structure
+ * \sa ::acr_runtime_mark_tile_dirty
+ */
+void acr_runtime_mark_all_tiles_dirty(struct acr_runtime_data *data);
+
+/**
+ * \brief Tell the monitor that the last kernel call modified the tiles its
+ * function computes
+ * \param[in,out] data The acr runtime data structure
+ * \pre Only called by the kernel thread, after the kernel call.
+ * \sa ::acr_runtime_mark_tile_dirty
+ */
+void acr_runtime_mark_computed_tiles_dirty(struct acr_runtime_data *data);
+
+/**
+ * \brief Wake up the monitor thread after a kernel call
+ * \param[in,out] data The acr runtime data structure
+ *
+ * The monitor is only signaled if it is sleeping, a monitor busy with the
+ * previous call sees the new one by itself.
+ */
+void acr_runtime_wake_monitor(struct acr_runtime_data *data);
+
+/**
+ * \brief Wake up the coordinator thread
+ * \param[in,out] data The acr runtime data structure
+ */
+void acr_runtime_wake_coordinator(struct acr_runtime_data *data);
+
+/**
+ * \brief Get the number of times the coordinator was woken up
+ * \param[in,out] data The acr runtime data structure
+ * \return The value to give to ::acr_runtime_wait_coordinator_wakeup
+ *
+ * Read it before checking the condition to wait for, a wake up happening
+ * after the check is not missed.
+ */
+size_t acr_runtime_coordinator_wakeups(struct acr_runtime_data *data);
+
+/**
+ * \brief Sleep until the coordinator is woken up
+ * \param[in,out] data The acr runtime data structure
+ * \param[in] wakeups The value returned by ::acr_runtime_coordinator_wakeups
+ * \remark Returns at once if the coordinator was woken up since.
+ */
+void acr_runtime_wait_coordinator_wakeup(
+    struct acr_runtime_data *data,
+    size_t wakeups);
+
+/**
+ * \brief Propose a new function to the kernel
+ * \param[in,out] data The acr runtime data structure
+ * \param[in] function The function, NULL to withdraw the current proposal
+ * \param[in] computed_tiles For each index of the outermost monitor
+ * dimension, true if the function computes one of its tiles. NULL if it
+ * computes every tile. Must live as long as the kernel can run the function.
+ * \return The previous proposal, NULL if the kernel already took it
+ */
+void* acr_runtime_propose_function(
+    struct acr_runtime_data *data,
+    void *function,
+    const bool *computed_tiles);
+
+/**
+ * \brief Take the function proposed to the kernel, if any
+ * \param[in,out] data The acr runtime data structure
+ * \return The proposed function, NULL if there is none
+ */
+void* acr_runtime_take_alternative_function(struct acr_runtime_data *data);
+
+/**
+ * \brief Sleep until the coordinator gives an alternative function
+ * \param[in,out] data The acr runtime data structure
+ * \return The alternative function, taken from the runtime data
+ */
+void* acr_runtime_wait_alternative_function(struct acr_runtime_data *data);
+
+/**
+ * \brief Wake up a kernel waiting in ::acr_runtime_wait_alternative_function
+ * \param[in,out] data The acr runtime data structure
+ */
+void acr_runtime_wake_kernel(struct acr_runtime_data *data);
+
+/**
+ * \brief Record the time spent inside of the kernel function by one call
+ * \param[in,out] data The acr runtime data structure
+ * \param[in] function The function that was called
+ * \param[in] time The time spent inside of the function
+ *
+ * The coordinator uses these timings to keep the faster function and to
+ * decide when a TCC version is worth compiling with cc.
+ * \pre Only called by the kernel thread, while time_kernel_calls is set.
+ */
+void acr_runtime_record_kernel_time(
+    struct acr_runtime_data *data,
+    void *function,
+    double time);
+
 /**
  * \brief Return the number of alternatives
  * \param[in] data The acr runtime data structure
@@ -250,9 +449,25 @@ size_t acr_runtime_get_num_alternatives(struct acr_runtime_data*data);
 /**
  * \brief Initialize the grid with static functions
  * \param[in,out] static_data The static data structure.
+ *
+ * \remark You can use the *ACR_PRECISION_MAP_DIR* environment variable to
+ * start from the precision map saved by a previous run. The map is only used
+ * if the kernel bounds, grid size and alternatives did not change.
  */
 void acr_static_data_init_grid(struct acr_runtime_data_static *static_data);
 
+/**
+ * \brief Sort the scanned tiles by wavefront
+ * \param[in,out] static_data The static data structure, with the tile origins.
+ * \param[in] num_tiles The number of scanned tiles.
+ *
+ * The wavefront of a tile is the sum of its coordinates in the grid. The
+ * tiles of a wavefront keep their scanning order.
+ */
+void acr_static_data_init_wavefronts(
+    struct acr_runtime_data_static *static_data,
+    size_t num_tiles);
+
 /**
  * \brief Initialize the compiler flags
  * \param[out] opt The compiler options to initialize
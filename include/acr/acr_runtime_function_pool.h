@@ -0,0 +1,113 @@
+/*
+ * Copyright (C) 2016 Maxime Schmitt
+ *
+ * ACR is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ *
+ * \file acr_runtime_function_pool.h
+ * \brief Slot reuse in the pool of generated functions
+ *
+ * \defgroup runtime_function_pool
+ *
+ * @{
+ * \brief Least recently used choice of the pool slot to reuse
+ *
+ * The slots are identified by their index and never move: the index of the
+ * slot used by the kernel and the one of the slot proposed to it stay valid
+ * while other slots are reused or added. Only the coordinator uses the pool.
+ *
+ */
+
+#ifndef __ACR_RUNTIME_FUNCTION_POOL_H
+#define __ACR_RUNTIME_FUNCTION_POOL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+/**
+ * \brief Use history of the pool slots
+ */
+struct acr_function_pool {
+  /** \brief The number of slots in use */
+  size_t num_slots;
+  /** \brief The number of slots the pool can grow to */
+  size_t max_slots;
+  /** \brief Incremented each time the kernel takes a slot */
+  uint64_t clock;
+  /** \brief The clock value of the last use of each slot, 0 if never used */
+  uint64_t *last_used;
+};
+
+/**
+ * \brief Tells if a slot holds nothing in progress and can be overwritten
+ * \param[in] slot The slot index.
+ * \param[in] user_data The data given to ::acr_function_pool_choose_slot.
+ */
+typedef bool (*acr_function_pool_reusable)(size_t slot, void *user_data);
+
+/**
+ * \brief Initialize a pool history
+ * \param[out] pool The pool to initialize.
+ * \param[in] num_slots The initial number of slots.
+ * \param[in] max_slots The maximal number of slots.
+ */
+void acr_function_pool_init(struct acr_function_pool *pool,
+    size_t num_slots, size_t max_slots);
+
+/**
+ * \brief Free a pool history
+ * \param[in,out] pool The pool to free.
+ */
+void acr_function_pool_free(struct acr_function_pool *pool);
+
+/**
+ * \brief Record that the kernel uses a slot
+ * \param[in,out] pool The pool.
+ * \param[in] slot The slot index.
+ */
+void acr_function_pool_touch(struct acr_function_pool *pool, size_t slot);
+
+/**
+ * \brief Add a slot at the end of the pool
+ * \param[in,out] pool The pool.
+ * \retval true If the new slot index is the previous number of slots.
+ * \retval false If the pool already has its maximal size.
+ */
+bool acr_function_pool_grow(struct acr_function_pool *pool);
+
+/**
+ * \brief Choose the reusable slot least recently used by the kernel
+ * \param[in] pool The pool.
+ * \param[in] used_by_kernel The slot the kernel uses, never chosen.
+ * \param[in] proposed_to_kernel The slot proposed to the kernel, never
+ *            chosen.
+ * \param[in] reusable Tells which slots can be overwritten.
+ * \param[in] user_data Given to reusable.
+ * \return The chosen slot index, the number of slots if none can be reused.
+ */
+size_t acr_function_pool_choose_slot(const struct acr_function_pool *pool,
+    size_t used_by_kernel, size_t proposed_to_kernel,
+    acr_function_pool_reusable reusable, void *user_data);
+
+#endif // __ACR_RUNTIME_FUNCTION_POOL_H
+
+/**
+ *
+ * @}
+ *
+ */
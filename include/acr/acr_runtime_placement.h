@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2016 Maxime Schmitt
+ *
+ * ACR is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ *
+ * \file acr_runtime_placement.h
+ * \brief CPU affinity and priority of the runtime threads
+ *
+ * \defgroup runtime_placement
+ *
+ * @{
+ * \brief Keep the runtime threads away from the simulation threads
+ *
+ * Each class of runtime threads can be pinned to a set of CPUs and the
+ * compile threads can run with a lower priority. The setting is shared by
+ * all the kernels and is used by the threads started after it.
+ *
+ * \remark You can use the *ACR_MONITOR_CPUS*, *ACR_COORDINATOR_CPUS*,
+ * *ACR_CLOOG_CPUS* and *ACR_COMPILE_CPUS* environment variables to pin the
+ * threads to a list of CPUs such as "0-3,8".
+ * \remark You can use the *ACR_COMPILE_NICE* environment variable to give a
+ * nice value to the compile threads, or "idle" to use the SCHED_IDLE policy.
+ *
+ */
+
+#ifndef __ACR_RUNTIME_PLACEMENT_H
+#define __ACR_RUNTIME_PLACEMENT_H
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <sys/types.h>
+
+/**
+ * \brief The classes of runtime threads
+ */
+enum acr_thread_class {
+  /** The monitoring thread and its helpers */
+  acr_thread_monitor = 0,
+  /** The coordinator thread */
+  acr_thread_coordinator,
+  /** The code generation threads */
+  acr_thread_cloog,
+  /** The compile threads and the compile server */
+  acr_thread_compile,
+  /** The number of classes */
+  acr_thread_num_classes,
+};
+
+/**
+ * \brief Pin a class of runtime threads to a set of CPUs
+ * \param[in] thread_class The class of threads.
+ * \param[in] num_cpus The number of CPUs, 0 to not pin the threads.
+ * \param[in] cpus The CPU numbers.
+ */
+void acr_runtime_set_thread_cpus(
+    enum acr_thread_class thread_class,
+    size_t num_cpus,
+    const int *cpus);
+
+/**
+ * \brief Set the priority of the compile threads
+ * \param[in] nice_value The nice value of the threads, 0 to keep the default.
+ * \param[in] idle Use the SCHED_IDLE policy, the threads only run on idle
+ * CPUs.
+ */
+void acr_runtime_set_compile_threads_priority(int nice_value, bool idle);
+
+/**
+ * \brief Apply the CPU affinity and priority of its class to the calling
+ * thread
+ * \param[in] thread_class The class of the calling thread.
+ */
+void acr_runtime_place_thread(enum acr_thread_class thread_class);
+
+/**
+ * \brief Apply the CPU affinity and priority of the compile threads to a
+ * process
+ * \param[in] pid The process id.
+ */
+void acr_runtime_place_compile_process(pid_t pid);
+
+#endif // __ACR_RUNTIME_PLACEMENT_H
+
+/**
+ *
+ * @}
+ *
+ */
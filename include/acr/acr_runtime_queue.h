@@ -0,0 +1,128 @@
+/*
+ * Copyright (C) 2016 Maxime Schmitt
+ *
+ * ACR is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ *
+ * \file acr_runtime_queue.h
+ * \brief Work queues between the runtime threads
+ *
+ * \defgroup runtime_queue
+ *
+ * @{
+ * \brief Bounded lock-free multi-producer multi-consumer queue
+ *
+ * Pushing and popping never take a lock. A consumer finding the queue empty
+ * can sleep with ::acr_queue_pop_wait, the producers only take the sleep
+ * mutex to wake it up.
+ *
+ */
+
+#ifndef __ACR_RUNTIME_QUEUE_H
+#define __ACR_RUNTIME_QUEUE_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+/**
+ * \brief A queue element and its sequence number
+ */
+struct acr_queue_cell {
+  /** \brief Tells if the cell is ready to be written or read */
+  atomic_size_t sequence;
+  /** \brief The queued element */
+  void *item;
+};
+
+/**
+ * \brief Bounded multi-producer multi-consumer queue
+ */
+struct acr_queue {
+  /** \brief The number of cells minus one, the capacity is a power of 2 */
+  size_t mask;
+  /** \brief The cells */
+  struct acr_queue_cell *cells;
+  /** \brief The next position to write */
+  _Alignas(64) atomic_size_t enqueue_position;
+  /** \brief The next position to read */
+  _Alignas(64) atomic_size_t dequeue_position;
+  /** \brief The number of consumers sleeping in ::acr_queue_pop_wait */
+  _Alignas(64) atomic_size_t num_sleeping;
+  /** \brief Set once the consumers must stop */
+  atomic_bool closed;
+  /** \brief Only used by sleeping consumers and to wake them up */
+  pthread_mutex_t sleep_mutex;
+  /** \brief Signaled when an element is pushed to a queue with sleepers */
+  pthread_cond_t not_empty;
+};
+
+/**
+ * \brief Initialize a queue
+ * \param[out] queue The queue to initialize.
+ * \param[in] capacity The minimum number of elements the queue can hold.
+ */
+void acr_queue_init(struct acr_queue *queue, size_t capacity);
+
+/**
+ * \brief Free a queue
+ * \param[in,out] queue The queue to free. The remaining elements are dropped.
+ */
+void acr_queue_free(struct acr_queue *queue);
+
+/**
+ * \brief Add an element at the end of the queue
+ * \param[in,out] queue The queue.
+ * \param[in] item The element.
+ * \retval true If the element was added.
+ * \retval false If the queue is full.
+ */
+bool acr_queue_push(struct acr_queue *queue, void *item);
+
+/**
+ * \brief Take the element at the front of the queue if any
+ * \param[in,out] queue The queue.
+ * \param[out] item The element.
+ * \retval true If an element was taken.
+ * \retval false If the queue is empty.
+ */
+bool acr_queue_try_pop(struct acr_queue *queue, void **item);
+
+/**
+ * \brief Take up to max_items elements, sleep while the queue is empty
+ * \param[in,out] queue The queue.
+ * \param[out] items Where to store the elements.
+ * \param[in] max_items The maximum number of elements to take.
+ * \return The number of elements taken. 0 once the queue is closed.
+ */
+size_t acr_queue_pop_wait(struct acr_queue *queue, void **items,
+    size_t max_items);
+
+/**
+ * \brief Wake up every sleeping consumer and make them return 0
+ * \param[in,out] queue The queue.
+ */
+void acr_queue_close(struct acr_queue *queue);
+
+#endif // __ACR_RUNTIME_QUEUE_H
+
+/**
+ *
+ * @}
+ *
+ */
@@ -94,6 +94,33 @@ void acr_verify_2dstencil(
     bool *required_compilation,
     bool *still_valid);
 
+/**
+ * \brief The implementations of the verification functions
+ */
+enum acr_verify_implementation {
+  /** \brief Portable scalar code */
+  acr_verify_implementation_scalar = 0,
+  /** \brief x86 SSE4.1 */
+  acr_verify_implementation_sse41,
+  /** \brief x86 AVX2 */
+  acr_verify_implementation_avx2,
+  /** \brief x86 AVX-512 (F and BW) */
+  acr_verify_implementation_avx512,
+  /** \brief The number of implementations */
+  acr_verify_num_implementations,
+};
+
+/**
+ * \brief Use an implementation instead of the best one for the processor
+ * \param[in] implementation The implementation.
+ * \retval true If the implementation is used from now on.
+ * \retval false If the processor or the compiler does not support it, the
+ * implementation in use is kept.
+ * \warning Must not be called while another thread verifies a grid.
+ */
+bool acr_verify_use_implementation(
+    enum acr_verify_implementation implementation);
+
 #endif // __ACR_RUNTIME_VERIFY_H
 
 /**
@@ -188,6 +188,21 @@ typedef struct acr_monitor {
   acr_array_declaration data_monitored;
   /** \brief The processing function */
   enum acr_monitor_processing_funtion processing_function;
+  /**
+   * \brief The number of elements read per tile, 0 to read the whole tile
+   *
+   * The elements are evenly strided in each dimension of the tile, there is
+   * no random sampling.
+   */
+  size_t sampling;
+  /**
+   * \brief True if the kernel only writes the monitored array inside of the
+   * tiles it computes
+   *
+   * The monitor then keeps the result of the tiles skipped by a zero
+   * computation alternative instead of scanning them again.
+   */
+  bool incremental;
 } acr_monitor;
 
 /**
@@ -752,6 +767,45 @@ static inline char* acr_monitor_get_filter_name(acr_option option) {
   return option->options.monitor.filter_name;
 }
 
+/**
+ * \brief Get the number of elements read per tile
+ * \param[in] option The monitor option
+ * \return The number of elements read per tile, 0 if the whole tile is read
+ */
+static inline size_t acr_monitor_get_sampling(const acr_option option) {
+  return option->options.monitor.sampling;
+}
+
+/**
+ * \brief Set the number of elements read per tile
+ * \param[in] sampling The number of elements, 0 to read the whole tile
+ * \param[out] option The monitor option
+ */
+static inline void acr_monitor_set_sampling(size_t sampling,
+    acr_option option) {
+  option->options.monitor.sampling = sampling;
+}
+
+/**
+ * \brief Check if the monitor only scans the tiles the kernel computed
+ * \param[in] option The monitor option
+ * \retval true If the incremental clause was given
+ * \retval false Otherwise
+ */
+static inline bool acr_monitor_get_incremental(const acr_option option) {
+  return option->options.monitor.incremental;
+}
+
+/**
+ * \brief Set if the monitor only scans the tiles the kernel computed
+ * \param[in] incremental True if the incremental clause was given
+ * \param[out] option The monitor option
+ */
+static inline void acr_monitor_set_incremental(bool incremental,
+    acr_option option) {
+  option->options.monitor.incremental = incremental;
+}
+
 /**
  * \brief Set a new array declaration
  * \param[in] num_specifiers The number of specifiers
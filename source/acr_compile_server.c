@@ -0,0 +1,167 @@
+/*
+ * Copyright (C) 2016 Maxime Schmitt
+ *
+ * ACR is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ * Compile server spawned by the ACR runtime. It keeps the fork and exec of the
+ * system compiler out of the simulation process.
+ *
+ * The server reads its requests on its standard input, which is one end of a
+ * socket pair, and exits when the runtime closes the other end. The protocol
+ * is described in acr_runtime_build.h.
+ */
+
+#include <errno.h>
+#include <spawn.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+extern char **environ;
+
+static int acr_server_read(int fd, void *buffer, size_t size) {
+  char *position = buffer;
+  while (size > 0) {
+    ssize_t num_read = read(fd, position, size);
+    if (num_read == -1 && errno == EINTR)
+      continue;
+    if (num_read <= 0)
+      return -1;
+    position += num_read;
+    size -= (size_t) num_read;
+  }
+  return 0;
+}
+
+static int acr_server_write(int fd, const void *buffer, size_t size) {
+  const char *position = buffer;
+  while (size > 0) {
+    ssize_t num_written = write(fd, position, size);
+    if (num_written == -1 && errno == EINTR)
+      continue;
+    if (num_written <= 0)
+      return -1;
+    position += num_written;
+    size -= (size_t) num_written;
+  }
+  return 0;
+}
+
+static char* acr_server_read_string(int fd, uint64_t *size) {
+  if (acr_server_read(fd, size, sizeof(*size)) != 0)
+    return NULL;
+  char *string = malloc((*size + 1) * sizeof(*string));
+  if (string == NULL)
+    return NULL;
+  if (acr_server_read(fd, string, *size) != 0) {
+    free(string);
+    return NULL;
+  }
+  string[*size] = '\0';
+  return string;
+}
+
+static int acr_server_compile(char **options, const char *source,
+    uint64_t source_size) {
+  int pipedescriptor[2];
+  if (pipe(pipedescriptor) != 0) {
+    perror("pipe");
+    return -1;
+  }
+  posix_spawn_file_actions_t actions;
+  posix_spawn_file_actions_init(&actions);
+  posix_spawn_file_actions_adddup2(&actions, pipedescriptor[0], STDIN_FILENO);
+  posix_spawn_file_actions_addclose(&actions, pipedescriptor[0]);
+  posix_spawn_file_actions_addclose(&actions, pipedescriptor[1]);
+  pid_t pid;
+  int spawn_error =
+    posix_spawn(&pid, options[0], &actions, NULL, options, environ);
+  posix_spawn_file_actions_destroy(&actions);
+  close(pipedescriptor[0]);
+  if (spawn_error != 0) {
+    fprintf(stderr, "posix_spawn: %s\n", strerror(spawn_error));
+    close(pipedescriptor[1]);
+    return -1;
+  }
+  // The compiler may stop reading on error, its exit status tells the rest
+  acr_server_write(pipedescriptor[1], source, source_size);
+  close(pipedescriptor[1]);
+  int exit_status;
+  pid_t waited;
+  do {
+    waited = waitpid(pid, &exit_status, 0);
+  } while (waited == -1 && errno == EINTR);
+  if (waited != pid || !WIFEXITED(exit_status))
+    return -1;
+  return WEXITSTATUS(exit_status);
+}
+
+static int acr_server_answer(int fd, int32_t status, const char *path) {
+  uint64_t path_size = path ? strlen(path) : 0;
+  if (acr_server_write(fd, &status, sizeof(status)) != 0 ||
+      acr_server_write(fd, &path_size, sizeof(path_size)) != 0 ||
+      acr_server_write(fd, path, path_size) != 0)
+    return -1;
+  return 0;
+}
+
+int main(void) {
+  const int fd = STDIN_FILENO;
+  for (;;) {
+    uint64_t num_options;
+    if (acr_server_read(fd, &num_options, sizeof(num_options)) != 0)
+      break; // The runtime closed the socket
+    char **options = calloc(num_options + 1, sizeof(*options));
+    if (options == NULL)
+      return EXIT_FAILURE;
+    int error = 0;
+    const char *output_filename = NULL;
+    for (uint64_t i = 0; i < num_options && !error; ++i) {
+      uint64_t option_size;
+      options[i] = acr_server_read_string(fd, &option_size);
+      error = options[i] == NULL;
+      if (!error && i > 0 && strcmp(options[i-1], "-o") == 0)
+        output_filename = options[i];
+    }
+    uint64_t source_size;
+    char *source = error ? NULL : acr_server_read_string(fd, &source_size);
+    if (source == NULL || num_options == 0) {
+      for (uint64_t i = 0; i < num_options; ++i)
+        free(options[i]);
+      free(options);
+      free(source);
+      return EXIT_FAILURE;
+    }
+
+    int32_t status = acr_server_compile(options, source, source_size);
+    if (status != 0)
+      output_filename = NULL;
+    int answered = acr_server_answer(fd, status, output_filename);
+
+    for (uint64_t i = 0; i < num_options; ++i)
+      free(options[i]);
+    free(options);
+    free(source);
+    if (answered != 0)
+      break;
+  }
+  return EXIT_SUCCESS;
+}
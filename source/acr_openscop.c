@@ -19,6 +19,8 @@
 #include "acr/acr_openscop.h"
 
 #include <isl/constraint.h>
+#include <isl/map.h>
+#include <isl/mat.h>
 #include <isl/set.h>
 #include <osl/body.h>
 #include <osl/extensions/scatnames.h>
@@ -616,6 +618,231 @@ void acr_openscop_get_monitoring_position_and_num(
   osl_strings_free(identifiers);
 }
 
+// One union part of an OpenScop relation, the local dimensions are
+// existentially quantified
+static isl_basic_map* acr_osl_relation_part_to_isl(
+    isl_ctx *ctx,
+    const osl_relation_p relation) {
+  unsigned int num_equalities = 0;
+  for (int i = 0; i < relation->nb_rows; ++i) {
+    if (osl_int_zero(relation->precision, relation->m[i][0]))
+      num_equalities += 1;
+  }
+  const unsigned int num_columns = (unsigned int) relation->nb_columns - 1;
+  isl_mat *equalities = isl_mat_alloc(ctx, num_equalities, num_columns);
+  isl_mat *inequalities = isl_mat_alloc(ctx,
+      (unsigned int) relation->nb_rows - num_equalities, num_columns);
+  unsigned int equality_row = 0, inequality_row = 0;
+  for (int i = 0; i < relation->nb_rows; ++i) {
+    const bool is_equality =
+      osl_int_zero(relation->precision, relation->m[i][0]);
+    for (unsigned int j = 0; j < num_columns; ++j) {
+      const int value =
+        (int) osl_int_get_si(relation->precision, relation->m[i][j+1]);
+      if (is_equality)
+        equalities = isl_mat_set_element_si(equalities,
+            (int) equality_row, (int) j, value);
+      else
+        inequalities = isl_mat_set_element_si(inequalities,
+            (int) inequality_row, (int) j, value);
+    }
+    if (is_equality)
+      equality_row += 1;
+    else
+      inequality_row += 1;
+  }
+  isl_space *space = isl_space_alloc(ctx,
+      (unsigned int) relation->nb_parameters,
+      (unsigned int) relation->nb_input_dims,
+      (unsigned int) relation->nb_output_dims);
+  return isl_basic_map_from_constraint_matrices(space,
+      equalities, inequalities,
+      isl_dim_out, isl_dim_in, isl_dim_div, isl_dim_param, isl_dim_cst);
+}
+
+static isl_map* acr_osl_relation_to_isl(
+    isl_ctx *ctx,
+    osl_relation_p relation) {
+  isl_map *map = isl_map_from_basic_map(
+      acr_osl_relation_part_to_isl(ctx, relation));
+  for (relation = relation->next; relation != NULL;
+      relation = relation->next) {
+    map = isl_map_union(map, isl_map_from_basic_map(
+          acr_osl_relation_part_to_isl(ctx, relation)));
+  }
+  return map;
+}
+
+struct acr_osl_access {
+  isl_map *accessed;
+  int array_id;
+  bool is_write;
+};
+
+// Map the iterations to the tile containing them, the tiles start at the
+// multiples of the grid size
+static isl_map* acr_osl_iterations_to_tiles(
+    isl_space *iteration_space,
+    size_t first_monitor_dimension,
+    size_t num_monitor_dims,
+    int grid_size) {
+  isl_space *space = isl_space_from_domain(iteration_space);
+  space = isl_space_add_dims(space, isl_dim_out, (unsigned int) num_monitor_dims);
+  isl_local_space *lspace = isl_local_space_from_space(isl_space_copy(space));
+  isl_map *tiles = isl_map_universe(space);
+  for (size_t i = 0; i < num_monitor_dims; ++i) {
+    const int dim = (int) (first_monitor_dimension + i);
+    // it - grid * tile >= 0
+    isl_constraint *c =
+      isl_constraint_alloc_inequality(isl_local_space_copy(lspace));
+    c = isl_constraint_set_coefficient_si(c, isl_dim_in, dim, 1);
+    c = isl_constraint_set_coefficient_si(c, isl_dim_out, (int) i, -grid_size);
+    tiles = isl_map_add_constraint(tiles, c);
+    // grid * tile + grid - 1 - it >= 0
+    c = isl_constraint_alloc_inequality(isl_local_space_copy(lspace));
+    c = isl_constraint_set_coefficient_si(c, isl_dim_in, dim, -1);
+    c = isl_constraint_set_coefficient_si(c, isl_dim_out, (int) i, grid_size);
+    c = isl_constraint_set_constant_si(c, grid_size - 1);
+    tiles = isl_map_add_constraint(tiles, c);
+  }
+  isl_local_space_free(lspace);
+  return tiles;
+}
+
+// The pairs of tiles touching the same element, one of them writing it
+static bool acr_osl_get_tile_conflicts(
+    isl_ctx *ctx,
+    const osl_scop_p scop,
+    size_t first_monitor_dimension,
+    size_t num_monitor_dims,
+    int grid_size,
+    isl_map **tile_conflicts) {
+  const size_t last_monitor_dimension =
+    first_monitor_dimension + num_monitor_dims;
+  *tile_conflicts = NULL;
+
+  size_t num_accesses = 0;
+  for (osl_statement_p statement = scop->statement; statement != NULL;
+      statement = statement->next) {
+    if ((size_t) statement->domain->nb_output_dims < last_monitor_dimension)
+      return false; // Not split in tiles
+    for (osl_relation_list_p access = statement->access; access != NULL;
+        access = access->next) {
+      num_accesses += 1;
+    }
+  }
+
+  struct acr_osl_access *accesses = malloc(num_accesses * sizeof(*accesses));
+  num_accesses = 0;
+  for (osl_statement_p statement = scop->statement; statement != NULL;
+      statement = statement->next) {
+    isl_set *domain =
+      isl_map_range(acr_osl_relation_to_isl(ctx, statement->domain));
+    for (osl_relation_list_p access = statement->access; access != NULL;
+        access = access->next) {
+      accesses[num_accesses].accessed = isl_map_intersect_domain(
+          acr_osl_relation_to_isl(ctx, access->elt),
+          isl_set_copy(domain));
+      accesses[num_accesses].array_id = osl_relation_get_array_id(access->elt);
+      accesses[num_accesses].is_write = access->elt->type != OSL_TYPE_READ;
+      num_accesses += 1;
+    }
+    isl_set_free(domain);
+  }
+
+  bool known = true;
+  for (size_t i = 0; known && i < num_accesses; ++i) {
+    for (size_t j = i; known && j < num_accesses; ++j) {
+      if (!accesses[i].is_write && !accesses[j].is_write)
+        continue;
+      if (accesses[i].array_id != accesses[j].array_id)
+        continue;
+      if (isl_map_dim(accesses[i].accessed, isl_dim_out) !=
+          isl_map_dim(accesses[j].accessed, isl_dim_out)) {
+        known = false;
+        continue;
+      }
+      isl_map *conflicts = isl_map_apply_range(
+          isl_map_copy(accesses[i].accessed),
+          isl_map_reverse(isl_map_copy(accesses[j].accessed)));
+      isl_space *space = isl_map_get_space(conflicts);
+      conflicts = isl_map_apply_domain(conflicts,
+          acr_osl_iterations_to_tiles(isl_space_domain(isl_space_copy(space)),
+            first_monitor_dimension, num_monitor_dims, grid_size));
+      conflicts = isl_map_apply_range(conflicts,
+          acr_osl_iterations_to_tiles(isl_space_range(space),
+            first_monitor_dimension, num_monitor_dims, grid_size));
+      conflicts = isl_map_union(conflicts,
+          isl_map_reverse(isl_map_copy(conflicts)));
+      if (*tile_conflicts == NULL)
+        *tile_conflicts = conflicts;
+      else
+        *tile_conflicts = isl_map_union(*tile_conflicts, conflicts);
+    }
+  }
+
+  for (size_t i = 0; i < num_accesses; ++i) {
+    isl_map_free(accesses[i].accessed);
+  }
+  free(accesses);
+  if (!known) {
+    isl_map_free(*tile_conflicts);
+    *tile_conflicts = NULL;
+  }
+  return known;
+}
+
+enum acr_tile_schedule acr_osl_get_tile_schedule(
+    const osl_scop_p scop,
+    size_t first_monitor_dimension,
+    size_t num_monitor_dims,
+    size_t grid_size) {
+  if (num_monitor_dims == 0)
+    return acr_tile_schedule_sequential;
+
+  isl_ctx *ctx = isl_ctx_alloc();
+  isl_map *tile_conflicts;
+  enum acr_tile_schedule schedule = acr_tile_schedule_sequential;
+  if (!acr_osl_get_tile_conflicts(ctx, scop, first_monitor_dimension,
+        num_monitor_dims, (int) grid_size, &tile_conflicts)) {
+    isl_ctx_free(ctx);
+    return schedule;
+  }
+  if (tile_conflicts == NULL) {
+    isl_ctx_free(ctx);
+    return acr_tile_schedule_parallel;
+  }
+
+  isl_space *space = isl_map_get_space(tile_conflicts);
+  isl_map *same_tile = isl_map_identity(isl_space_copy(space));
+  if (isl_map_is_subset(tile_conflicts, same_tile) == isl_bool_true) {
+    schedule = acr_tile_schedule_parallel;
+  } else {
+    // The tile computed first in the sequential order must be in a previous
+    // wavefront, the sum of the tile coordinates
+    isl_map *ordered = isl_map_intersect(isl_map_copy(tile_conflicts),
+        isl_map_lex_lt(isl_space_range(isl_space_copy(space))));
+    isl_local_space *lspace = isl_local_space_from_space(isl_space_copy(space));
+    isl_constraint *c = isl_constraint_alloc_inequality(lspace);
+    for (size_t i = 0; i < num_monitor_dims; ++i) {
+      c = isl_constraint_set_coefficient_si(c, isl_dim_in, (int) i, -1);
+      c = isl_constraint_set_coefficient_si(c, isl_dim_out, (int) i, 1);
+    }
+    c = isl_constraint_set_constant_si(c, -1);
+    isl_map *later_wavefront =
+      isl_map_add_constraint(isl_map_universe(isl_space_copy(space)), c);
+    if (isl_map_is_subset(ordered, later_wavefront) == isl_bool_true)
+      schedule = acr_tile_schedule_wavefront;
+    isl_map_free(ordered);
+    isl_map_free(later_wavefront);
+  }
+  isl_space_free(space);
+  isl_map_free(same_tile);
+  isl_map_free(tile_conflicts);
+  isl_ctx_free(ctx);
+  return schedule;
+}
+
 void acr_openscop_get_identifiers_with_dependencies(
     const acr_option monitor,
     const osl_scop_p scop,
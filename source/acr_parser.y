@@ -105,6 +105,7 @@ struct parser_option_list* option_list;
   acr_array_dimension array_dimensions;
   struct array_dimensions_list *dimension_list;
   int monitor_processing_function;
+  size_t monitor_sampling;
   bool minus;
 }
 
@@ -144,12 +145,14 @@ struct parser_option_list* option_list;
 %type <minus> minus
 %type <option> acr_alternative_options acr_option
 %type <option> acr_strategy_options acr_monitor_options acr_init_option
+%type <option> acr_monitor_declaration
 %type <alternative_parameter> acr_alternative_parameter_swap
 %type <alternative_function> acr_alternative_function_swap
 %type <parameter_decl> parameter_declaration
 %type <parameter_decl_list> parameter_declaration_list
 %type <array_declaration> acr_monitor_data_monitored
 %type <monitor_processing_function> acr_monitor_processing_function
+%type <monitor_sampling> acr_monitor_sampling
 %type <dimension_list> array_dimensions
 
 
@@ -527,6 +530,32 @@ pointer
   ;
 
 acr_monitor_options
+  : acr_monitor_declaration
+    {
+      $$ = $1;
+    }
+  | acr_monitor_options acr_monitor_sampling
+    {
+      $$ = $1;
+      if ($$)
+        acr_monitor_set_sampling($2, $$);
+    }
+  | acr_monitor_options IDENTIFIER
+    {
+      if (strcmp($2, "incremental") != 0) {
+        fprintf(stderr, "[ACR] Error: unknown monitor clause %s,"
+        " did you mean \"incremental\"?\n", $2);
+        free($2);
+        YYERROR;
+      }
+      $$ = $1;
+      if ($$)
+        acr_monitor_set_incremental(true, $$);
+      free($2);
+    }
+  ;
+
+acr_monitor_declaration
   : '(' acr_monitor_data_monitored ',' acr_monitor_processing_function ')'
     {
       if ($2.num_dimensions == 0 || $2.num_specifiers == 0) {
@@ -552,6 +581,26 @@ acr_monitor_options
       free($6);
     }
   ;
+acr_monitor_sampling
+  : IDENTIFIER '(' I_CONSTANT ')'
+    {
+      if (strcmp($1, "sample") != 0) {
+        fprintf(stderr, "[ACR] Error: unknown monitor clause %s,"
+        " did you mean \"sample\"?\n", $1);
+        free($1);
+        YYERROR;
+      }
+      if ($3.value.integer_val.integer <= 0) {
+        fprintf(stderr, "[ACR] Error: the number of samples per tile must be"
+        " positive\n");
+        free($1);
+        YYERROR;
+      }
+      $$ = $3.value.integer_val.uinteger;
+      free($1);
+    }
+  ;
+
 acr_monitor_data_monitored
   : parameter_declaration array_dimensions
     {
@@ -17,15 +17,29 @@
  */
 
 #include "acr/acr_runtime_build.h"
+#include "acr/acr_runtime_cache.h"
 #include "acr/compiler_name.h"
 #include "acr/acr_runtime_data.h"
+#include "acr/acr_runtime_placement.h"
 
 #include <dlfcn.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <spawn.h>
 #include <stdio.h>
 #include <string.h>
 #include <unistd.h>
+#include <sys/socket.h>
 #include <sys/wait.h>
 
+#ifdef MIR_PRESENT
+#include <c2mir.h>
+#include <mir-gen.h>
+#endif
+
+extern char **environ;
+
 static const size_t acr_temporary_file_length = 29;
 static const char acr_temporary_file_prefix[] = "/tmp/acr-runtime-temp-XXXXXX";
 
@@ -58,34 +72,155 @@ void acr_append_necessary_compile_flags(
   (*options)[*num_options-1] = NULL;
 }
 
-char* acr_compile_with_system_compiler(
-    char *requested_filename,
+bool acr_compile_server_start(
+    struct acr_compile_server *server,
+    const char *server_path) {
+  server->pid = -1;
+  server->socket = -1;
+  if (server_path == NULL) {
+    server_path = access(acr_compile_server_path, X_OK) == 0 ?
+      acr_compile_server_path : acr_compile_server_build_path;
+  }
+  int socket_pair[2];
+  if (socketpair(AF_UNIX, SOCK_STREAM, 0, socket_pair) != 0) {
+    perror("socketpair");
+    return false;
+  }
+  // Other servers and compilers must not inherit the runtime end, the server
+  // would never see the end of file otherwise.
+  if (fcntl(socket_pair[0], F_SETFD, FD_CLOEXEC) == -1) {
+    perror("fcntl");
+    close(socket_pair[0]);
+    close(socket_pair[1]);
+    return false;
+  }
+  posix_spawn_file_actions_t actions;
+  posix_spawn_file_actions_init(&actions);
+  posix_spawn_file_actions_adddup2(&actions, socket_pair[1], STDIN_FILENO);
+  posix_spawn_file_actions_addclose(&actions, socket_pair[1]);
+  char *argv[] = { (char *) server_path, NULL };
+  int spawn_error = posix_spawn(&server->pid, server_path, &actions, NULL,
+      argv, environ);
+  posix_spawn_file_actions_destroy(&actions);
+  close(socket_pair[1]);
+  if (spawn_error != 0) {
+    fprintf(stderr, "Warning: Could not spawn the compile server \"%s\": %s\n",
+        server_path, strerror(spawn_error));
+    close(socket_pair[0]);
+    server->pid = -1;
+    return false;
+  }
+  acr_runtime_place_compile_process(server->pid);
+  server->socket = socket_pair[0];
+  return true;
+}
+
+void acr_compile_server_stop(struct acr_compile_server *server) {
+  if (server->socket != -1) {
+    close(server->socket);
+    server->socket = -1;
+  }
+  if (server->pid != -1) {
+    while (waitpid(server->pid, NULL, 0) == -1 && errno == EINTR);
+    server->pid = -1;
+  }
+}
+
+static int acr_compile_server_send(int fd, const void *buffer, size_t size) {
+  const char *position = buffer;
+  while (size > 0) {
+    // A dead server must not kill the simulation with SIGPIPE
+    ssize_t num_sent = send(fd, position, size, MSG_NOSIGNAL);
+    if (num_sent == -1 && errno == EINTR)
+      continue;
+    if (num_sent <= 0)
+      return -1;
+    position += num_sent;
+    size -= (size_t) num_sent;
+  }
+  return 0;
+}
+
+static int acr_compile_server_receive(int fd, void *buffer, size_t size) {
+  char *position = buffer;
+  while (size > 0) {
+    ssize_t num_read = read(fd, position, size);
+    if (num_read == -1 && errno == EINTR)
+      continue;
+    if (num_read <= 0)
+      return -1;
+    position += num_read;
+    size -= (size_t) num_read;
+  }
+  return 0;
+}
+
+static int acr_compile_server_send_string(int fd, const char *string) {
+  uint64_t size = strlen(string);
+  if (acr_compile_server_send(fd, &size, sizeof(size)) != 0)
+    return -1;
+  return acr_compile_server_send(fd, string, size);
+}
+
+/**
+ * \brief Ask the compile server to build a shared object
+ * \retval 1 If the shared object was built.
+ * \retval 0 If the compiler failed.
+ * \retval -1 If the server did not answer. The server is stopped.
+ */
+static int acr_compile_with_server(
+    struct acr_compile_server *server,
     const char *string_to_compile,
     size_t num_options,
     char** options) {
+  const int fd = server->socket;
+  // The last option is the NULL terminator
+  uint64_t num_sent_options = num_options - 1;
+  int error = acr_compile_server_send(fd, &num_sent_options,
+      sizeof(num_sent_options));
+  for (size_t i = 0; !error && i < num_options - 1; ++i) {
+    error = acr_compile_server_send_string(fd, options[i]);
+  }
+  error = error || acr_compile_server_send_string(fd, string_to_compile);
 
-  char *output_filename;
-  if (requested_filename) {
-    output_filename = requested_filename;
-  } else {
-    output_filename =
-      malloc(acr_temporary_file_length * sizeof(*output_filename));
-    memcpy(output_filename, acr_temporary_file_prefix, acr_temporary_file_length);
-    int fd = mkstemp(output_filename);
-    if (fd == -1) {
-      perror("mkstemp");
-      exit(EXIT_FAILURE);
-    }
-
-    close(fd);
+  int32_t status;
+  uint64_t path_size;
+  error = error ||
+    acr_compile_server_receive(fd, &status, sizeof(status)) ||
+    acr_compile_server_receive(fd, &path_size, sizeof(path_size));
+  char *path = NULL;
+  if (!error) {
+    path = malloc((path_size + 1) * sizeof(*path));
+    error = acr_compile_server_receive(fd, path, path_size);
+    path[path_size] = '\0';
   }
-  options[num_options-2] = output_filename;
+  if (error) {
+    fprintf(stderr, "Warning: The compile server stopped answering\n");
+    free(path);
+    acr_compile_server_stop(server);
+    return -1;
+  }
+  // The server builds the file the runtime asked for
+  int built = status == 0 && strcmp(path, options[num_options-2]) == 0;
+  free(path);
+  return built;
+}
+
+static int acr_compile_with_fork(
+    const char *string_to_compile,
+    char** options) {
   int pipedescriptor[2];
   if (pipe(pipedescriptor) != 0) {
     perror("pipe");
-    exit(EXIT_FAILURE);
+    return 0;
   }
   pid_t pid = fork();
+  if (pid == -1) {
+    perror("fork");
+    close(pipedescriptor[0]);
+    close(pipedescriptor[1]);
+    return 0;
+  }
   if (pid == 0) { // child
     close(pipedescriptor[1]);
     if(dup2(pipedescriptor[0], STDIN_FILENO) == -1) {
@@ -101,23 +236,223 @@ char* acr_compile_with_system_compiler(
   FILE *pipe_to_child_stdin = fdopen(pipedescriptor[1], "w");
   if (!pipe_to_child_stdin) {
     perror("fdopen");
-    exit(EXIT_FAILURE);
+    close(pipedescriptor[1]);
+    waitpid(pid, NULL, 0);
+    return 0;
   }
   fprintf(pipe_to_child_stdin, "%s", string_to_compile);
   fclose(pipe_to_child_stdin);
   int exit_status;
   pid_t waited = waitpid(pid, &exit_status, 0);
-  if (waited != pid || !WIFEXITED(exit_status) ||
-      (WIFEXITED(exit_status) && (WEXITSTATUS(exit_status) != 0))) {
+  return waited == pid && WIFEXITED(exit_status) &&
+    WEXITSTATUS(exit_status) == 0;
+}
+
+char* acr_compile_with_system_compiler(
+    struct acr_compile_server *server,
+    char *requested_filename,
+    const char *string_to_compile,
+    size_t num_options,
+    char** options) {
+
+  char *output_filename;
+  if (requested_filename) {
+    output_filename = requested_filename;
+  } else {
+    output_filename =
+      malloc(acr_temporary_file_length * sizeof(*output_filename));
+    memcpy(output_filename, acr_temporary_file_prefix, acr_temporary_file_length);
+    int fd = mkstemp(output_filename);
+    if (fd == -1) {
+      perror("mkstemp");
+      free(output_filename);
+      return NULL;
+    }
+
+    close(fd);
+  }
+  options[num_options-2] = output_filename;
+  int built = -1;
+  if (server && server->socket != -1) {
+    built = acr_compile_with_server(server, string_to_compile,
+        num_options, options);
+  }
+  if (built == -1) {
+    built = acr_compile_with_fork(string_to_compile, options);
+  }
+  if (!built) {
     if(unlink(output_filename) != 0) {
       perror("unlink");
-      exit(EXIT_FAILURE);
     }
+    if (output_filename != requested_filename)
+      free(output_filename);
     return NULL;
   }
   return output_filename;
 }
 
+// Gives the name of the header if the line is an #include "header"
+static bool acr_quoted_include(const char *line,
+    const char **name, size_t *name_length) {
+  while (*line == ' ' || *line == '\t')
+    ++line;
+  if (*line++ != '#')
+    return false;
+  while (*line == ' ' || *line == '\t')
+    ++line;
+  if (strncmp(line, "include", 7) != 0)
+    return false;
+  line += 7;
+  while (*line == ' ' || *line == '\t')
+    ++line;
+  if (*line != '"')
+    return false;
+  *name = line + 1;
+  *name_length = strcspn(*name, "\"\n");
+  return (*name)[*name_length] == '"';
+}
+
+static char* acr_read_whole_file(const char *filename) {
+  FILE *file = fopen(filename, "rb");
+  if (file == NULL)
+    return NULL;
+  char *content = NULL;
+  long size;
+  if (fseek(file, 0, SEEK_END) == 0 && (size = ftell(file)) >= 0 &&
+      fseek(file, 0, SEEK_SET) == 0) {
+    content = malloc(((size_t) size + 1) * sizeof(*content));
+    if (fread(content, 1, (size_t) size, file) != (size_t) size) {
+      free(content);
+      content = NULL;
+    } else {
+      content[size] = '\0';
+    }
+  }
+  fclose(file);
+  return content;
+}
+
+// The headers included with quotes are found in the -I directories, their
+// content is part of the cache key so that editing them gives a new key
+static uint64_t acr_hash_local_includes(
+    uint64_t hash,
+    const char *code,
+    size_t num_options,
+    char** options,
+    unsigned int max_depth) {
+  if (max_depth == 0)
+    return hash;
+  for (const char *line = code; line != NULL;) {
+    const char *name;
+    size_t name_length;
+    if (acr_quoted_include(line, &name, &name_length)) {
+      hash = acr_hash_bytes(hash, name, name_length);
+      for (size_t i = 0; i < num_options - 2; ++i) {
+        if (strncmp(options[i], "-I", 2) != 0 || options[i][2] == '\0')
+          continue;
+        int path_size = snprintf(NULL, 0, "%s/%.*s",
+            options[i] + 2, (int) name_length, name) + 1;
+        char *path = malloc((size_t) path_size * sizeof(*path));
+        snprintf(path, (size_t) path_size, "%s/%.*s",
+            options[i] + 2, (int) name_length, name);
+        char *header = acr_read_whole_file(path);
+        free(path);
+        if (header != NULL) {
+          hash = acr_hash_bytes(hash, header, strlen(header) + 1);
+          hash = acr_hash_local_includes(hash, header,
+              num_options, options, max_depth - 1);
+          free(header);
+          break;
+        }
+      }
+    }
+    line = strchr(line, '\n');
+    if (line != NULL)
+      ++line;
+  }
+  return hash;
+}
+
+static char* acr_compile_cache_filename(
+    const char *cache_dir,
+    const char *string_to_compile,
+    size_t num_options,
+    char** options) {
+  uint64_t hash = ACR_HASH_INIT;
+  // The last two options are the output file and the NULL terminator. The
+  // null characters are hashed too so that they act as separators.
+  for (size_t i = 0; i < num_options - 2; ++i) {
+    hash = acr_hash_bytes(hash, options[i], strlen(options[i]) + 1);
+  }
+  hash = acr_hash_bytes(hash, string_to_compile, strlen(string_to_compile) + 1);
+  hash = acr_hash_local_includes(hash, string_to_compile,
+      num_options, options, 8);
+
+  int name_size =
+    snprintf(NULL, 0, "%s/acr-%016" PRIx64 ".so", cache_dir, hash);
+  if (name_size < 0) {
+    fprintf(stderr, "[ACR] Warning: Could not generate the cache file name,"
+        " the version is compiled without the cache\n");
+    return NULL;
+  }
+  char *filename = malloc(((size_t) name_size + 1) * sizeof(*filename));
+  snprintf(filename, (size_t) name_size + 1,
+      "%s/acr-%016" PRIx64 ".so", cache_dir, hash);
+  return filename;
+}
+
+char* acr_compile_with_system_compiler_cached(
+    struct acr_compile_server *server,
+    const char *cache_dir,
+    const char *string_to_compile,
+    size_t num_options,
+    char** options,
+    bool *in_cache) {
+  char *cache_filename = acr_compile_cache_filename(
+      cache_dir, string_to_compile, num_options, options);
+  *in_cache = cache_filename != NULL;
+  if (cache_filename == NULL) {
+    return acr_compile_with_system_compiler(server, NULL,
+        string_to_compile, num_options, options);
+  }
+  if (access(cache_filename, R_OK) == 0) {
+    return cache_filename;
+  }
+
+  // Compile to a unique file first and rename it afterwards so that other
+  // threads or processes never load a partially written object.
+  const size_t cache_filename_length = strlen(cache_filename);
+  char *temporary_filename =
+    malloc((cache_filename_length + 8) * sizeof(*temporary_filename));
+  memcpy(temporary_filename, cache_filename, cache_filename_length);
+  memcpy(temporary_filename + cache_filename_length, "-XXXXXX", 8);
+  int fd = mkstemp(temporary_filename);
+  if (fd == -1) {
+    perror("mkstemp");
+    free(temporary_filename);
+    free(cache_filename);
+    return NULL;
+  }
+  close(fd);
+
+  char *compiled = acr_compile_with_system_compiler(server,
+      temporary_filename, string_to_compile, num_options, options);
+  if (compiled == NULL) {
+    free(temporary_filename);
+    free(cache_filename);
+    return NULL;
+  }
+  if (rename(temporary_filename, cache_filename) == -1) {
+    perror("rename");
+    unlink(temporary_filename);
+    free(temporary_filename);
+    free(cache_filename);
+    return NULL;
+  }
+  free(temporary_filename);
+  return cache_filename;
+}
+
 #ifdef TCC_PRESENT
 
 TCCState* acr_compile_with_tcc(
@@ -127,17 +462,90 @@ TCCState* acr_compile_with_tcc(
   tcc_set_output_type(compile_state, TCC_OUTPUT_MEMORY);
   if(tcc_compile_string(compile_state, string_to_compile) == -1) {
     fprintf(stderr, "Tcc compilation failed\n%s\n", string_to_compile);
-    exit(EXIT_FAILURE);
+    tcc_delete(compile_state);
+    return NULL;
   }
   if(tcc_relocate(compile_state, TCC_RELOCATE_AUTO) == -1) {
     fprintf(stderr, "Tcc relocation failed\n");
-    exit(EXIT_FAILURE);
+    tcc_delete(compile_state);
+    return NULL;
   }
   return compile_state;
 }
 
 #endif
 
+#ifdef MIR_PRESENT
+
+struct acr_mir_source {
+  const char *position;
+};
+
+static int acr_mir_getc(void *data) {
+  struct acr_mir_source *source = (struct acr_mir_source *) data;
+  if (*source->position == '\0')
+    return EOF;
+  return (unsigned char) *source->position++;
+}
+
+// The generated code may call any function of the simulation process. The
+// resolver takes no user data, the process handle of the thread linking a
+// context is kept here while it links.
+static _Thread_local void *acr_mir_process_handle;
+
+static void* acr_mir_import_resolver(const char *name) {
+  return dlsym(acr_mir_process_handle, name);
+}
+
+MIR_context_t acr_compile_with_mir(
+    const char *string_to_compile,
+    const char *function_name,
+    void **function) {
+  *function = NULL;
+  MIR_context_t context = MIR_init();
+  c2mir_init(context);
+  const char *include_dirs[] = { "." };
+  struct c2mir_options options;
+  memset(&options, 0, sizeof(options));
+  options.message_file = stderr;
+  options.include_dirs_num = 1;
+  options.include_dirs = include_dirs;
+  struct acr_mir_source source = { .position = string_to_compile };
+  int compiled = c2mir_compile(context, &options, acr_mir_getc, &source,
+      "acr_alternative_function.c", NULL);
+  c2mir_finish(context);
+  if (!compiled) {
+    fprintf(stderr, "MIR compilation failed\n");
+    MIR_finish(context);
+    return NULL;
+  }
+
+  // The context is new, the module c2mir created is the only one
+  MIR_load_module(context,
+      DLIST_HEAD(MIR_module_t, *MIR_get_module_list(context)));
+  // The linker gives the address of the function to an import of it
+  MIR_module_t lookup = MIR_new_module(context, "acr_function_lookup");
+  MIR_item_t function_import = MIR_new_import(context, function_name);
+  MIR_finish_module(context);
+  MIR_load_module(context, lookup);
+  MIR_gen_init(context);
+  MIR_gen_set_optimize_level(context, 2);
+  // Generate the machine code of every function now, not at the first call
+  acr_mir_process_handle = dlopen(NULL, RTLD_LAZY);
+  MIR_link(context, MIR_set_gen_interface, acr_mir_import_resolver);
+  dlclose(acr_mir_process_handle);
+  acr_mir_process_handle = NULL;
+  *function = function_import->addr;
+  return context;
+}
+
+void acr_free_mir_context(MIR_context_t context) {
+  MIR_gen_finish(context);
+  MIR_finish(context);
+}
+
+#endif
+
 /*
 
 void acr_code_generation_compile_and_get_functions(
@@ -153,7 +561,7 @@ void acr_code_generation_compile_and_get_functions(
   size_t num_compile_options;
   acr_compile_flags(&compile_options, &num_compile_options);
 
-  char *compiled_filename = acr_compile_with_system_compiler(NULL,
+  char *compiled_filename = acr_compile_with_system_compiler(NULL, NULL,
       library_code, num_compile_options, compile_options);
 
   static_data->dl_handle = dlopen(compiled_filename, RTLD_LAZY);
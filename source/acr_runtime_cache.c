@@ -0,0 +1,213 @@
+/*
+ * Copyright (C) 2016 Maxime Schmitt
+ *
+ * ACR is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "acr/acr_runtime_cache.h"
+
+#include <dlfcn.h>
+#include <stdio.h>
+#include <string.h>
+
+static const uint64_t acr_fnv_prime = UINT64_C(1099511628211);
+
+uint64_t acr_hash_bytes(uint64_t hash, const void *bytes, size_t size) {
+  const unsigned char *byte = (const unsigned char *) bytes;
+  for (size_t i = 0; i < size; ++i) {
+    hash ^= byte[i];
+    hash *= acr_fnv_prime;
+  }
+  return hash;
+}
+
+void acr_unload_shared_object(void *dlhandle) {
+  dlclose(dlhandle);
+}
+
+void acr_version_cache_init(
+    struct acr_version_cache *cache,
+    size_t capacity,
+    size_t monitor_size,
+    const unsigned char value_keys[UCHAR_MAX + 1]) {
+  pthread_mutex_init(&cache->mutex, NULL);
+  cache->capacity = capacity;
+  cache->monitor_size = monitor_size;
+  memcpy(cache->value_keys, value_keys, sizeof(cache->value_keys));
+  cache->clock = 0;
+  cache->entries = calloc(capacity, sizeof(*cache->entries));
+}
+
+static void acr_version_cache_clear_entry(
+    struct acr_version_cache_entry *entry) {
+  free(entry->key);
+  free(entry->generated_code);
+  for (size_t tier = 0; tier < acr_version_num_tiers; ++tier) {
+    struct acr_version_cache_code *code = &entry->compiled[tier];
+    if (code->handle)
+      code->unload(code->handle);
+    code->handle = NULL;
+    code->unload = NULL;
+    code->function = NULL;
+  }
+  entry->key = NULL;
+  entry->generated_code = NULL;
+}
+
+void acr_version_cache_free(struct acr_version_cache *cache) {
+  for (size_t i = 0; i < cache->capacity; ++i) {
+    acr_version_cache_clear_entry(&cache->entries[i]);
+  }
+  free(cache->entries);
+  cache->entries = NULL;
+  pthread_mutex_destroy(&cache->mutex);
+}
+
+// The key is hashed value by value to avoid building it for each lookup
+static uint64_t acr_version_cache_hash(
+    const struct acr_version_cache *cache,
+    const unsigned char *monitor_result) {
+  uint64_t hash = ACR_HASH_INIT;
+  for (size_t i = 0; i < cache->monitor_size; ++i) {
+    hash ^= cache->value_keys[monitor_result[i]];
+    hash *= acr_fnv_prime;
+  }
+  return hash;
+}
+
+static bool acr_version_cache_same_key(
+    const struct acr_version_cache *cache,
+    const unsigned char *key,
+    const unsigned char *monitor_result) {
+  for (size_t i = 0; i < cache->monitor_size; ++i) {
+    if (key[i] != cache->value_keys[monitor_result[i]])
+      return false;
+  }
+  return true;
+}
+
+static struct acr_version_cache_entry* acr_version_cache_find(
+    struct acr_version_cache *cache,
+    uint64_t hash,
+    const unsigned char *monitor_result) {
+  for (size_t i = 0; i < cache->capacity; ++i) {
+    struct acr_version_cache_entry *entry = &cache->entries[i];
+    if (entry->key && entry->hash == hash &&
+        acr_version_cache_same_key(cache, entry->key, monitor_result))
+      return entry;
+  }
+  return NULL;
+}
+
+struct acr_version_cache_entry* acr_version_cache_acquire(
+    struct acr_version_cache *cache,
+    const unsigned char *monitor_result) {
+  const uint64_t hash = acr_version_cache_hash(cache, monitor_result);
+  pthread_mutex_lock(&cache->mutex);
+  struct acr_version_cache_entry *entry =
+    acr_version_cache_find(cache, hash, monitor_result);
+  if (entry) {
+    entry->users += 1;
+    entry->last_use = ++cache->clock;
+  }
+  pthread_mutex_unlock(&cache->mutex);
+  return entry;
+}
+
+struct acr_version_cache_entry* acr_version_cache_insert(
+    struct acr_version_cache *cache,
+    const unsigned char *monitor_result,
+    const char *generated_code) {
+  const uint64_t hash = acr_version_cache_hash(cache, monitor_result);
+  pthread_mutex_lock(&cache->mutex);
+  // An other thread may have generated the same grid in the meantime
+  struct acr_version_cache_entry *entry =
+    acr_version_cache_find(cache, hash, monitor_result);
+  if (entry == NULL) {
+    for (size_t i = 0; i < cache->capacity; ++i) {
+      struct acr_version_cache_entry *candidate = &cache->entries[i];
+      if (candidate->users != 0)
+        continue;
+      if (candidate->key == NULL) {
+        entry = candidate;
+        break;
+      }
+      if (entry == NULL || candidate->last_use < entry->last_use)
+        entry = candidate;
+    }
+    if (entry == NULL) { // Every entry is in use, the version is not cached
+      pthread_mutex_unlock(&cache->mutex);
+      return NULL;
+    }
+    acr_version_cache_clear_entry(entry);
+    entry->hash = hash;
+    entry->key = malloc(cache->monitor_size * sizeof(*entry->key));
+    for (size_t i = 0; i < cache->monitor_size; ++i)
+      entry->key[i] = cache->value_keys[monitor_result[i]];
+    size_t code_size = strlen(generated_code) + 1;
+    entry->generated_code = malloc(code_size * sizeof(*entry->generated_code));
+    memcpy(entry->generated_code, generated_code, code_size);
+  }
+  entry->users += 1;
+  entry->last_use = ++cache->clock;
+  pthread_mutex_unlock(&cache->mutex);
+  return entry;
+}
+
+void acr_version_cache_release(
+    struct acr_version_cache *cache,
+    struct acr_version_cache_entry *entry) {
+  if (entry == NULL)
+    return;
+  pthread_mutex_lock(&cache->mutex);
+  entry->users -= 1;
+  pthread_mutex_unlock(&cache->mutex);
+}
+
+void* acr_version_cache_get_function(
+    struct acr_version_cache *cache,
+    struct acr_version_cache_entry *entry,
+    enum acr_version_cache_tier tier) {
+  if (entry == NULL)
+    return NULL;
+  pthread_mutex_lock(&cache->mutex);
+  void *function = entry->compiled[tier].function;
+  pthread_mutex_unlock(&cache->mutex);
+  return function;
+}
+
+void* acr_version_cache_set_function(
+    struct acr_version_cache *cache,
+    struct acr_version_cache_entry *entry,
+    enum acr_version_cache_tier tier,
+    void *code_handle,
+    acr_code_unload unload_code,
+    void *function) {
+  struct acr_version_cache_code *code = &entry->compiled[tier];
+  bool already_compiled;
+  pthread_mutex_lock(&cache->mutex);
+  already_compiled = code->handle != NULL;
+  if (!already_compiled) {
+    code->handle = code_handle;
+    code->unload = unload_code;
+    code->function = function;
+  } else {
+    function = code->function;
+  }
+  pthread_mutex_unlock(&cache->mutex);
+  if (already_compiled)
+    unload_code(code_handle);
+  return function;
+}
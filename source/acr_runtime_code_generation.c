@@ -143,23 +143,260 @@ void acr_cloog_get_rid_of_parameter(
   }
 }
 
-static void acr_isl_set_from_monitor(
+// Above this proportion of changed tiles the domains are built from scratch
+static const size_t acr_incremental_generation_ratio = 8;
+
+void acr_cloog_generation_buffer_init(
+    struct acr_cloog_generation_buffer *buffer,
+    const struct acr_runtime_data *data_info) {
+  buffer->sets =
+    malloc(data_info->num_alternatives * sizeof(*buffer->sets));
+  buffer->previous_sets =
+    malloc(data_info->num_alternatives * sizeof(*buffer->previous_sets));
+  buffer->previous_data = NULL;
+  buffer->changed_tiles = malloc((data_info->monitor_total_size /
+        acr_incremental_generation_ratio + 1) *
+      sizeof(*buffer->changed_tiles));
+  const unsigned long num_columns =
+    data_info->monitor_dim_max[data_info->num_monitor_dims - 1];
+  buffer->open_rectangles =
+    malloc(num_columns * sizeof(*buffer->open_rectangles));
+  buffer->next_open_rectangles =
+    malloc(num_columns * sizeof(*buffer->next_open_rectangles));
+  buffer->first_tile =
+    malloc(data_info->num_monitor_dims * sizeof(*buffer->first_tile));
+  buffer->last_tile =
+    malloc(data_info->num_monitor_dims * sizeof(*buffer->last_tile));
+}
+
+void acr_cloog_generation_buffer_free(
+    struct acr_cloog_generation_buffer *buffer,
+    const struct acr_runtime_data *data_info) {
+  if (buffer->previous_data) {
+    for (size_t i = 0; i < data_info->num_alternatives; ++i) {
+      isl_set_free(buffer->previous_sets[i]);
+    }
+  }
+  free(buffer->sets);
+  free(buffer->previous_sets);
+  free(buffer->previous_data);
+  free(buffer->changed_tiles);
+  free(buffer->open_rectangles);
+  free(buffer->next_open_rectangles);
+  free(buffer->first_tile);
+  free(buffer->last_tile);
+}
+
+isl_set* acr_isl_set_tile_box(
+    isl_space *space,
+    size_t grid_size,
+    const unsigned long *first_tile,
+    const unsigned long *last_tile) {
+  isl_ctx *ctx = isl_space_get_ctx(space);
+  isl_val *tiling_size_val = isl_val_int_from_ui(ctx, grid_size);
+  const unsigned int num_dims = (unsigned int) isl_space_dim(space, isl_dim_set);
+  isl_set *box = isl_set_universe(space);
+  for (unsigned int j = num_dims-1; j < num_dims; --j) {
+    isl_local_space *local_space =
+      isl_local_space_from_space(isl_set_get_space(box));
+    isl_constraint *c_lower = isl_constraint_alloc_inequality(
+        local_space);
+    isl_constraint *c_upper = isl_constraint_copy(c_lower);
+
+    isl_val *lower_bound =
+      isl_val_mul_ui(isl_val_copy(tiling_size_val), first_tile[j]);
+    lower_bound = isl_val_neg(lower_bound);
+    c_lower =
+      isl_constraint_set_constant_val(c_lower, lower_bound);
+    c_lower =
+      isl_constraint_set_coefficient_si(c_lower, isl_dim_set, (int)j, 1);
+    box = isl_set_add_constraint(box, c_lower);
+
+    isl_val *upper_bound =
+      isl_val_mul_ui(isl_val_copy(tiling_size_val), last_tile[j]);
+    upper_bound = isl_val_add(upper_bound, isl_val_copy(tiling_size_val));
+    upper_bound = isl_val_sub_ui(upper_bound, 1);
+    c_upper =
+      isl_constraint_set_constant_val(c_upper, upper_bound);
+    c_upper =
+      isl_constraint_set_coefficient_si(c_upper, isl_dim_set, (int)j, -1);
+    box = isl_set_add_constraint(box, c_upper);
+  }
+  isl_val_free(tiling_size_val);
+  return box;
+}
+
+static void acr_isl_add_rectangle(
+    const struct acr_runtime_data *data_info,
+    size_t thread_num,
+    struct acr_cloog_generation_buffer *buffer,
+    unsigned long first_column,
+    unsigned long last_row,
+    isl_set **sets) {
+  const unsigned int num_dims = data_info->num_monitor_dims;
+  const struct acr_tile_rectangle *rectangle =
+    &buffer->open_rectangles[first_column];
+  buffer->first_tile[num_dims-1] = first_column;
+  buffer->last_tile[num_dims-1] = rectangle->last_column;
+  if (num_dims > 1) {
+    buffer->first_tile[num_dims-2] = rectangle->first_row;
+    buffer->last_tile[num_dims-2] = last_row;
+  }
+  isl_set *box = acr_isl_set_tile_box(
+      isl_set_get_space(data_info->empty_monitor_set[thread_num]),
+      data_info->grid_size, buffer->first_tile, buffer->last_tile);
+  sets[rectangle->alternative] =
+    isl_set_union(sets[rectangle->alternative], box);
+}
+
+// Merge the tiles into maximal row runs, then merge the runs spanning the
+// same columns on consecutive rows. Each rectangle becomes a single box.
+static void acr_isl_set_from_monitor_rectangles(
     const struct acr_runtime_data *data_info,
     const unsigned char*data,
     size_t thread_num,
+    struct acr_cloog_generation_buffer *buffer,
     isl_set **sets) {
+  const unsigned int num_dims = data_info->num_monitor_dims;
+  const unsigned long num_columns = data_info->monitor_dim_max[num_dims-1];
+  const unsigned long num_rows =
+    num_dims > 1 ? data_info->monitor_dim_max[num_dims-2] : 1;
+  const size_t num_slices =
+    data_info->monitor_total_size / (num_columns * num_rows);
+
+  for (size_t slice = 0; slice < num_slices; ++slice) {
+    size_t remaining = slice;
+    for (unsigned int j = num_dims > 2 ? num_dims - 2 : 0; j-- > 0;) {
+      buffer->first_tile[j] = remaining % data_info->monitor_dim_max[j];
+      buffer->last_tile[j] = buffer->first_tile[j];
+      remaining /= data_info->monitor_dim_max[j];
+    }
+    for (unsigned long column = 0; column < num_columns; ++column) {
+      buffer->open_rectangles[column].is_open = false;
+    }
 
-  for (size_t i = 0; i < data_info->num_alternatives; ++i) {
-    sets[i] = isl_set_copy(data_info->empty_monitor_set[thread_num]);
+    const unsigned char *slice_data = &data[slice * num_columns * num_rows];
+    for (unsigned long row = 0; row < num_rows; ++row) {
+      const unsigned char *row_data = &slice_data[row * num_columns];
+      for (unsigned long column = 0; column < num_columns; ++column) {
+        buffer->next_open_rectangles[column].is_open = false;
+      }
+      unsigned long first_column = 0;
+      while (first_column < num_columns) {
+        struct runtime_alternative *alternative =
+          data_info->alternative_from_val(row_data[first_column]);
+        assert(alternative != NULL);
+        unsigned long last_column = first_column;
+        while (last_column + 1 < num_columns &&
+            data_info->alternative_from_val(row_data[last_column+1]) ==
+            alternative) {
+          last_column += 1;
+        }
+        struct acr_tile_rectangle *open =
+          &buffer->open_rectangles[first_column];
+        struct acr_tile_rectangle *next =
+          &buffer->next_open_rectangles[first_column];
+        if (open->is_open && open->last_column == last_column &&
+            open->alternative == alternative->alternative_number) {
+          *next = *open;
+          open->is_open = false;
+        } else {
+          next->is_open = true;
+          next->alternative = alternative->alternative_number;
+          next->last_column = last_column;
+          next->first_row = row;
+        }
+        first_column = last_column + 1;
+      }
+      // Rectangles that did not grow on this row are finished
+      for (unsigned long column = 0; column < num_columns; ++column) {
+        if (buffer->open_rectangles[column].is_open)
+          acr_isl_add_rectangle(data_info, thread_num, buffer,
+              column, row - 1, sets);
+      }
+      struct acr_tile_rectangle *temp = buffer->open_rectangles;
+      buffer->open_rectangles = buffer->next_open_rectangles;
+      buffer->next_open_rectangles = temp;
+    }
+    for (unsigned long column = 0; column < num_columns; ++column) {
+      if (buffer->open_rectangles[column].is_open)
+        acr_isl_add_rectangle(data_info, thread_num, buffer,
+            column, num_rows - 1, sets);
+    }
+  }
+}
+
+void acr_cloog_alternative_sets_from_monitor(
+    const struct acr_runtime_data *data_info,
+    const unsigned char *data,
+    size_t thread_num,
+    struct acr_cloog_generation_buffer *buffer) {
+
+  const size_t max_changed_tiles =
+    data_info->monitor_total_size / acr_incremental_generation_ratio;
+  size_t num_changed_tiles = 0;
+  bool incremental = buffer->previous_data != NULL;
+
+  if (incremental) {
+    for(size_t i = 0; i < data_info->monitor_total_size; ++i) {
+      if (buffer->previous_data[i] != data[i] &&
+          data_info->alternative_from_val(buffer->previous_data[i]) !=
+          data_info->alternative_from_val(data[i])) {
+        if (num_changed_tiles == max_changed_tiles) {
+          incremental = false;
+          break;
+        }
+        buffer->changed_tiles[num_changed_tiles] = i;
+        num_changed_tiles += 1;
+      }
+    }
   }
 
-  for(size_t i = 0; i < data_info->monitor_total_size; ++i) {
-    struct runtime_alternative *alternative = data_info->alternative_from_val(data[i]);
-    assert(alternative != NULL);
+  isl_set **sets = buffer->previous_sets;
+  if (incremental) { // Only move the tiles that changed of alternative
+    for (size_t i = 0; i < num_changed_tiles; ++i) {
+      const size_t tile = buffer->changed_tiles[i];
+      struct runtime_alternative *old_alternative =
+        data_info->alternative_from_val(buffer->previous_data[tile]);
+      struct runtime_alternative *alternative =
+        data_info->alternative_from_val(data[tile]);
+      assert(alternative != NULL);
+
+      sets[old_alternative->alternative_number] =
+        isl_set_subtract(sets[old_alternative->alternative_number],
+            isl_set_copy(data_info->tiles_domains[thread_num][tile]));
+      sets[alternative->alternative_number] =
+        isl_set_union(sets[alternative->alternative_number],
+            isl_set_copy(data_info->tiles_domains[thread_num][tile]));
+    }
+    // Each subtraction splits the set around the tile, merge the pieces back
+    // or they pile up across calls
+    if (num_changed_tiles > 0) {
+      for (size_t i = 0; i < data_info->num_alternatives; ++i) {
+        sets[i] = isl_set_coalesce(sets[i]);
+      }
+    }
+  } else {
+    if (buffer->previous_data) {
+      for (size_t i = 0; i < data_info->num_alternatives; ++i) {
+        isl_set_free(sets[i]);
+      }
+    } else {
+      buffer->previous_data = malloc(data_info->monitor_total_size *
+          sizeof(*buffer->previous_data));
+    }
+
+    for (size_t i = 0; i < data_info->num_alternatives; ++i) {
+      sets[i] = isl_set_copy(data_info->empty_monitor_set[thread_num]);
+    }
+    acr_isl_set_from_monitor_rectangles(
+        data_info, data, thread_num, buffer, sets);
+  }
+  memcpy(buffer->previous_data, data,
+      data_info->monitor_total_size * sizeof(*buffer->previous_data));
 
-    sets[alternative->alternative_number] =
-      isl_set_union(sets[alternative->alternative_number],
-          isl_set_copy(data_info->tiles_domains[thread_num][i]));
+  for (size_t i = 0; i < data_info->num_alternatives; ++i) {
+    buffer->sets[i] = isl_set_copy(sets[i]);
   }
 }
 
@@ -168,12 +405,13 @@ void acr_cloog_generate_alternative_code_from_input(
     const struct acr_runtime_data *data_info,
     const unsigned char *data,
     size_t thread_num,
-    isl_set **temporary_alt_domain) {
+    struct acr_cloog_generation_buffer *generation_buffer) {
 
   CloogUnionDomain *new_udomain = cloog_union_domain_alloc(0);
+  isl_set **const temporary_alt_domain = generation_buffer->sets;
 
-  acr_isl_set_from_monitor(
-      data_info, data, thread_num, temporary_alt_domain);
+  acr_cloog_alternative_sets_from_monitor(
+      data_info, data, thread_num, generation_buffer);
 
   /*isl_printer *splinter = isl_printer_to_file(isl_set_get_ctx(*temporary_alt_domain), stderr);*/
   /*splinter = isl_printer_set_output_format(splinter, ISL_FORMAT_EXT_POLYLIB);*/
@@ -26,8 +26,10 @@
 #include <isl/constraint.h>
 #include <isl/set.h>
 #include <isl/map.h>
+#include <errno.h>
 #include <pthread.h>
 #include <string.h>
+#include <sys/stat.h>
 #include <unistd.h>
 #include <inttypes.h>
 
@@ -40,7 +42,7 @@ void free_acr_runtime_data_thread_specific(struct acr_runtime_data* data) {
   atomic_flag_clear_explicit(
       &data->monitor_thread_continue,
       memory_order_relaxed);
-  pthread_cond_signal(&data->coordinator_continue_cond);
+  acr_runtime_wake_coordinator(data);
   pthread_join(data->monitor_thread, NULL);
 }
 
@@ -82,6 +84,20 @@ void free_acr_runtime_data(struct acr_runtime_data* data) {
   for (size_t i = 0; i < data->num_compile_threads; ++i)
     free(data->compiler_flags[i]);
   free(data->compiler_flags);
+  free(data->compile_cache_dir);
+  data->compile_cache_dir = NULL;
+  if (data->compile_servers) {
+    for (size_t i = 0; i < data->num_compile_threads; ++i)
+      acr_compile_server_stop(&data->compile_servers[i]);
+    free(data->compile_servers);
+    data->compile_servers = NULL;
+  }
+  free(data->dirty_outer_tiles);
+  data->dirty_outer_tiles = NULL;
+  pthread_mutex_destroy(&data->monitor_sleep_mutex);
+  pthread_mutex_destroy(&data->coordinator_continue_mutex);
+  pthread_mutex_destroy(&data->alternative_function_mutex);
+  pthread_cond_destroy(&data->alternative_function_cond);
 }
 
 isl_map* isl_map_from_cloog_scattering(CloogScattering *scat);
@@ -97,46 +113,15 @@ static void init_isl_tiling_domain(struct acr_runtime_data *data) {
 
     isl_ctx *ctx = isl_set_get_ctx(data->context[k]);
     isl_space *space = isl_space_set_alloc(ctx, 0, data->num_monitor_dims);
-    isl_val *tiling_size_val = isl_val_int_from_ui(ctx, data->grid_size);
 
     isl_set *empty_domain = isl_set_empty(isl_space_copy(space));
     data->empty_monitor_set[k] = empty_domain;
 
-    isl_set *universe_domain = isl_set_universe(space);
-
     unsigned long *current_dimension =
       calloc(data->num_monitor_dims, sizeof(*current_dimension));
     for(size_t i = 0; i < data->monitor_total_size; ++i) {
-      data->tiles_domains[k][i] = isl_set_copy(universe_domain);
-      for (unsigned long j = data->num_monitor_dims-1; j < data->num_monitor_dims; --j) {
-        unsigned long dimensions_pos = current_dimension[j];
-        isl_local_space *local_space =
-          isl_local_space_from_space(isl_set_get_space(data->tiles_domains[k][i]));
-        isl_constraint *c_lower = isl_constraint_alloc_inequality(
-            local_space);
-        isl_constraint *c_upper = isl_constraint_copy(c_lower);
-
-        isl_val *lower_bound =
-          isl_val_mul_ui(isl_val_copy(tiling_size_val), dimensions_pos);
-        lower_bound = isl_val_neg(lower_bound);
-        c_lower =
-          isl_constraint_set_constant_val(c_lower, lower_bound);
-        c_lower =
-          isl_constraint_set_coefficient_si(c_lower, isl_dim_set, (int)j, 1);
-        data->tiles_domains[k][i] =
-          isl_set_add_constraint(data->tiles_domains[k][i], c_lower);
-
-        isl_val *upper_bound =
-          isl_val_mul_ui(isl_val_copy(tiling_size_val), dimensions_pos);
-        upper_bound = isl_val_add(upper_bound, isl_val_copy(tiling_size_val));
-        upper_bound = isl_val_sub_ui(upper_bound, 1);
-        c_upper =
-          isl_constraint_set_constant_val(c_upper, upper_bound);
-        c_upper =
-          isl_constraint_set_coefficient_si(c_upper, isl_dim_set, (int)j, -1);
-        data->tiles_domains[k][i] =
-          isl_set_add_constraint(data->tiles_domains[k][i], c_upper);
-      }
+      data->tiles_domains[k][i] = acr_isl_set_tile_box(isl_space_copy(space),
+          data->grid_size, current_dimension, current_dimension);
 
       for (unsigned long j = data->num_monitor_dims - 1; j < data->num_monitor_dims; --j) {
         current_dimension[j] += 1;
@@ -147,8 +132,7 @@ static void init_isl_tiling_domain(struct acr_runtime_data *data) {
         }
       }
     }
-    isl_set_free(universe_domain);
-    isl_val_free(tiling_size_val);
+    isl_space_free(space);
     free(current_dimension);
   }
 }
@@ -229,6 +213,94 @@ static void init_compile_flags(struct acr_runtime_data *data) {
   }
 }
 
+/**
+ * \brief Initialize the compiled kernel cache directory
+ * \param[in,out] data The runtime data
+ *
+ * \remark You can use the *ACR_CACHE_DIR* environment variable to keep the
+ * compiled kernels across runs. The directory is created if needed.
+ */
+static void init_compile_cache_dir(struct acr_runtime_data *data) {
+  data->compile_cache_dir = NULL;
+  char *cache_env = getenv("ACR_CACHE_DIR");
+  if (cache_env == NULL || cache_env[0] == '\0')
+    return;
+  if (mkdir(cache_env, 0700) == -1 && errno != EEXIST) {
+    fprintf(stderr,
+        "Warning: Cannot create \"%s\" from ACR_CACHE_DIR environment"
+        " variable: %s\n"
+        "         Compiled kernels will not be cached.\n",
+        cache_env, strerror(errno));
+    return;
+  }
+  if (access(cache_env, R_OK | W_OK | X_OK) == -1) {
+    fprintf(stderr,
+        "Warning: Bad value \"%s\" in ACR_CACHE_DIR environment"
+        " variable: %s\n"
+        "         Compiled kernels will not be cached.\n",
+        cache_env, strerror(errno));
+    return;
+  }
+  size_t cache_env_length = strlen(cache_env);
+  data->compile_cache_dir =
+    malloc((cache_env_length + 1) * sizeof(*data->compile_cache_dir));
+  memcpy(data->compile_cache_dir, cache_env,
+      (cache_env_length + 1) * sizeof(*data->compile_cache_dir));
+}
+
+// The servers spawned when the program starts, before the simulation
+// allocates its data, and not taken by a kernel yet
+static struct {
+  pthread_mutex_t mutex;
+  size_t num_servers;
+  struct acr_compile_server *servers;
+} acr_prespawned_compile_servers = {
+  .mutex = PTHREAD_MUTEX_INITIALIZER,
+};
+
+static bool acr_take_prespawned_compile_server(
+    struct acr_compile_server *server) {
+  pthread_mutex_lock(&acr_prespawned_compile_servers.mutex);
+  const bool taken = acr_prespawned_compile_servers.num_servers > 0;
+  if (taken) {
+    acr_prespawned_compile_servers.num_servers -= 1;
+    *server = acr_prespawned_compile_servers.servers[
+      acr_prespawned_compile_servers.num_servers];
+  }
+  pthread_mutex_unlock(&acr_prespawned_compile_servers.mutex);
+  return taken;
+}
+
+/**
+ * \brief Take the compile servers spawned at startup, spawn the missing ones
+ * \param[in,out] data The runtime data
+ *
+ * \remark You can use the *ACR_COMPILE_SERVER* environment variable to use
+ * another compile server executable. An empty value disables the servers and
+ * the compiler is forked from the simulation process.
+ */
+static void init_compile_servers(struct acr_runtime_data *data) {
+  data->compile_servers = NULL;
+  const char *server_path = getenv("ACR_COMPILE_SERVER");
+  if (server_path && server_path[0] == '\0')
+    return;
+  data->compile_servers =
+    malloc(data->num_compile_threads * sizeof(*data->compile_servers));
+  for (size_t i = 0; i < data->num_compile_threads; ++i) {
+    if (acr_take_prespawned_compile_server(&data->compile_servers[i]))
+      continue;
+    if (!acr_compile_server_start(&data->compile_servers[i], server_path)) {
+      fprintf(stderr,
+          "         The compiler will be forked from the simulation.\n");
+      for (size_t j = 0; j < i; ++j)
+        acr_compile_server_stop(&data->compile_servers[j]);
+      free(data->compile_servers);
+      data->compile_servers = NULL;
+      return;
+    }
+  }
+}
+
 void init_acr_runtime_data_thread_specific(struct acr_runtime_data *data) {
   atomic_flag_test_and_set_explicit(
       &data->monitor_thread_continue, memory_order_relaxed);
@@ -238,14 +310,18 @@ void init_acr_runtime_data_thread_specific(struct acr_runtime_data *data) {
  * \brief Initialize the number of threads used during the simulation
  * \param[out] codegen The number of code generation threads
  * \param[out] compile The number of compilation threads
+ * \param[out] monitor The number of monitoring threads
  *
  * \remark You can use the *ACR_GEN_THREADS* environment variable to set the
  * number of code generation threads.
  * \remark You can use the *ACR_COMPILE_THREADS* environment variable to set
  * the number of compilation threads.
+ * \remark You can use the *ACR_MONITOR_THREADS* environment variable to set
+ * the number of monitoring threads.
  *
  */
-static void init_num_threads(size_t *restrict codegen, size_t *restrict compile) {
+static void init_num_threads(size_t *restrict codegen, size_t *restrict compile,
+    size_t *restrict monitor) {
   char *codegen_env = getenv("ACR_GEN_THREADS");
   /*long num_threads = sysconf(_SC_NPROCESSORS_ONLN);*/
   /*num_threads /= 2;*/
@@ -285,6 +361,131 @@ static void init_num_threads(size_t *restrict codegen, size_t *restrict compile)
       *compile = *compile == 0 ? 1 : *compile;
     }
   }
+  char *monitor_env = getenv("ACR_MONITOR_THREADS");
+  if (monitor_env == NULL) {
+    *monitor = 1;
+  } else {
+    long env_threads;
+    int num_matched = sscanf(monitor_env, "%ld", &env_threads);
+    if (num_matched != 1) {
+      fprintf(stderr,
+          "Warning: Bad value \"%s\" in ACR_MONITOR_THREADS environment"
+          " variable.\n"
+          "         Default to %d threads.\n", monitor_env, 1);
+      *monitor = 1;
+    } else {
+      env_threads = env_threads < 0 ? -env_threads : env_threads;
+      *monitor = (size_t) env_threads;
+      *monitor = *monitor == 0 ? 1 : *monitor;
+    }
+  }
+}
+
+void acr_runtime_prespawn_compile_servers(void) {
+  const char *server_path = getenv("ACR_COMPILE_SERVER");
+  if (server_path && server_path[0] == '\0')
+    return;
+  size_t num_codegen, num_compile, num_monitor;
+  init_num_threads(&num_codegen, &num_compile, &num_monitor);
+  pthread_mutex_lock(&acr_prespawned_compile_servers.mutex);
+  acr_prespawned_compile_servers.servers =
+    realloc(acr_prespawned_compile_servers.servers,
+        (acr_prespawned_compile_servers.num_servers + num_compile) *
+        sizeof(*acr_prespawned_compile_servers.servers));
+  for (size_t i = 0; i < num_compile; ++i) {
+    struct acr_compile_server *server =
+      &acr_prespawned_compile_servers.servers[
+        acr_prespawned_compile_servers.num_servers];
+    // The kernel spawns its servers at initialization instead
+    if (!acr_compile_server_start(server, server_path))
+      break;
+    acr_prespawned_compile_servers.num_servers += 1;
+  }
+  pthread_mutex_unlock(&acr_prespawned_compile_servers.mutex);
+}
+
+/**
+ * \brief Initialize the tiered compilation policy
+ * \param[out] promotion_calls The number of kernel calls a TCC version must
+ * survive before it is compiled with the system compiler
+ *
+ * \remark You can use the *ACR_PROMOTION_CALLS* environment variable to set
+ * the number of calls. 0 compiles every version with both compilers at once.
+ *
+ */
+static void init_promotion_calls(size_t *promotion_calls) {
+  const size_t default_calls = 8;
+  char *calls_env = getenv("ACR_PROMOTION_CALLS");
+  if (calls_env == NULL) {
+    *promotion_calls = default_calls;
+  } else {
+    long env_calls;
+    int num_matched = sscanf(calls_env, "%ld", &env_calls);
+    if (num_matched != 1) {
+      fprintf(stderr,
+          "Warning: Bad value \"%s\" in ACR_PROMOTION_CALLS environment"
+          " variable.\n"
+          "         Default to %zu calls.\n", calls_env, default_calls);
+      *promotion_calls = default_calls;
+    } else {
+      env_calls = env_calls < 0 ? -env_calls : env_calls;
+      *promotion_calls = (size_t) env_calls;
+    }
+  }
+}
+
+/**
+ * \brief Initialize the size of the generated functions pool
+ * \param[out] initial The initial number of slots
+ * \param[out] maximum The number of slots the pool can grow to when every
+ * slot is busy
+ *
+ * \remark You can use the *ACR_FUNCTION_POOL_SIZE* environment variable to set
+ * the initial number of slots.
+ * \remark You can use the *ACR_FUNCTION_POOL_MAX_SIZE* environment variable
+ * to set the maximal number of slots.
+ *
+ */
+static void init_function_pool_size(
+    size_t *restrict initial, size_t *restrict maximum) {
+  const size_t default_initial = 10;
+  const size_t default_growth_factor = 4;
+  // Two slots are kept for the kernel, one more is needed for code generation
+  const size_t minimal_size = 3;
+
+  char *initial_env = getenv("ACR_FUNCTION_POOL_SIZE");
+  *initial = default_initial;
+  if (initial_env != NULL) {
+    long env_size;
+    int num_matched = sscanf(initial_env, "%ld", &env_size);
+    if (num_matched != 1) {
+      fprintf(stderr,
+          "Warning: Bad value \"%s\" in ACR_FUNCTION_POOL_SIZE environment"
+          " variable.\n"
+          "         Default to %zu functions.\n", initial_env, default_initial);
+    } else {
+      env_size = env_size < 0 ? -env_size : env_size;
+      *initial = (size_t) env_size;
+    }
+  }
+  *initial = *initial < minimal_size ? minimal_size : *initial;
+
+  char *maximum_env = getenv("ACR_FUNCTION_POOL_MAX_SIZE");
+  *maximum = *initial * default_growth_factor;
+  if (maximum_env != NULL) {
+    long env_size;
+    int num_matched = sscanf(maximum_env, "%ld", &env_size);
+    if (num_matched != 1) {
+      fprintf(stderr,
+          "Warning: Bad value \"%s\" in ACR_FUNCTION_POOL_MAX_SIZE environment"
+          " variable.\n"
+          "         Default to %zu functions.\n", maximum_env, *maximum);
+    } else {
+      env_size = env_size < 0 ? -env_size : env_size;
+      *maximum = (size_t) env_size;
+    }
+  }
+  *maximum = *maximum < *initial ? *initial : *maximum;
 }
 
 void init_acr_runtime_data(
@@ -302,7 +503,12 @@ void init_acr_runtime_data(
     _exit(0);
   }
 
-  init_num_threads(&data->num_codegen_threads, &data->num_compile_threads);
+  init_num_threads(&data->num_codegen_threads, &data->num_compile_threads,
+      &data->num_monitor_threads);
+  init_compile_servers(data);
+  init_promotion_calls(&data->promotion_calls);
+  init_function_pool_size(&data->function_pool_size,
+      &data->function_pool_max_size);
   data->osl_relation = acr_read_scop_from_buffer(scop, scop_size);
 
   data->monitor_total_size = 1;
@@ -310,6 +516,28 @@ void init_acr_runtime_data(
     data->monitor_total_size *= data->monitor_dim_max[i];
   }
 
+  atomic_init(&data->dirty_tracking, false);
+  data->proposed_computed_tiles = NULL;
+  data->kernel_computed_tiles = NULL;
+  data->dirty_outer_tiles =
+    malloc(data->monitor_dim_max[0] * sizeof(*data->dirty_outer_tiles));
+  for (size_t i = 0; i < data->monitor_dim_max[0]; ++i) {
+    atomic_init(&data->dirty_outer_tiles[i], true);
+  }
+
+  // The original kernel is timed until a first version is evaluated
+  atomic_init(&data->time_kernel_calls, true);
+  atomic_init(&data->timed_function, NULL);
+  atomic_init(&data->timed_function_calls, 0);
+  atomic_init(&data->timed_function_time, 0.);
+  atomic_init(&data->original_function_time, 0.);
+  pthread_mutex_init(&data->monitor_sleep_mutex, NULL);
+  atomic_init(&data->monitor_sleeping, false);
+  pthread_mutex_init(&data->coordinator_continue_mutex, NULL);
+  data->coordinator_wakeups = 0;
+  pthread_mutex_init(&data->alternative_function_mutex, NULL);
+  pthread_cond_init(&data->alternative_function_cond, NULL);
+
   for (size_t j = 0; j < data->num_alternatives; ++j) {
     struct runtime_alternative *alt = &data->alternatives[j];
     alt->restricted_domains =
@@ -360,6 +588,7 @@ void init_acr_runtime_data(
   free(cloog_inputs);
   init_isl_tiling_domain(data);
   init_compile_flags(data);
+  init_compile_cache_dir(data);
 }
 
 unsigned char* acr_runtime_get_runtime_data(struct acr_runtime_data* data) {
@@ -368,6 +597,162 @@ unsigned char* acr_runtime_get_runtime_data(struct acr_runtime_data* data) {
       memory_order_relaxed);
 }
 
+// The release stores pair with the acquire exchange of the monitor thread,
+// which then sees the data written before the tile was marked
+void acr_runtime_mark_tile_dirty(
+    struct acr_runtime_data *data,
+    size_t tile_index) {
+  if (tile_index >= data->monitor_total_size) {
+    acr_runtime_mark_all_tiles_dirty(data);
+    return;
+  }
+  const size_t outer_tile_size =
+    data->monitor_total_size / data->monitor_dim_max[0];
+  atomic_store_explicit(
+      &data->dirty_outer_tiles[tile_index / outer_tile_size],
+      true, memory_order_release);
+  atomic_store_explicit(&data->dirty_tracking, true, memory_order_relaxed);
+}
+
+void acr_runtime_mark_all_tiles_dirty(struct acr_runtime_data *data) {
+  for (size_t i = 0; i < data->monitor_dim_max[0]; ++i) {
+    atomic_store_explicit(&data->dirty_outer_tiles[i], true,
+        memory_order_release);
+  }
+  atomic_store_explicit(&data->dirty_tracking, true, memory_order_relaxed);
+}
+
+void acr_runtime_mark_computed_tiles_dirty(struct acr_runtime_data *data) {
+  const bool *const computed_tiles = data->kernel_computed_tiles;
+  if (computed_tiles == NULL) {
+    acr_runtime_mark_all_tiles_dirty(data);
+    return;
+  }
+  for (size_t i = 0; i < data->monitor_dim_max[0]; ++i) {
+    if (computed_tiles[i])
+      atomic_store_explicit(&data->dirty_outer_tiles[i], true,
+          memory_order_release);
+  }
+  atomic_store_explicit(&data->dirty_tracking, true, memory_order_relaxed);
+}
+
+void acr_runtime_wake_monitor(struct acr_runtime_data *data) {
+  // Pairs with the fence of the monitor thread: either the monitor sees the
+  // new call before sleeping or the kernel sees the monitor sleeping
+  atomic_thread_fence(memory_order_seq_cst);
+  // Only the first call after the monitor went to sleep signals it
+  if (atomic_load_explicit(&data->monitor_sleeping, memory_order_relaxed) &&
+      atomic_exchange_explicit(&data->monitor_sleeping, false,
+        memory_order_relaxed)) {
+    pthread_mutex_lock(&data->monitor_sleep_mutex);
+    pthread_cond_signal(&data->monitor_sleep_cond);
+    pthread_mutex_unlock(&data->monitor_sleep_mutex);
+  }
+}
+
+void acr_runtime_wake_coordinator(struct acr_runtime_data *data) {
+  pthread_mutex_lock(&data->coordinator_continue_mutex);
+  data->coordinator_wakeups += 1;
+  pthread_cond_signal(&data->coordinator_continue_cond);
+  pthread_mutex_unlock(&data->coordinator_continue_mutex);
+}
+
+size_t acr_runtime_coordinator_wakeups(struct acr_runtime_data *data) {
+  pthread_mutex_lock(&data->coordinator_continue_mutex);
+  const size_t wakeups = data->coordinator_wakeups;
+  pthread_mutex_unlock(&data->coordinator_continue_mutex);
+  return wakeups;
+}
+
+void acr_runtime_wait_coordinator_wakeup(
+    struct acr_runtime_data *data,
+    size_t wakeups) {
+  pthread_mutex_lock(&data->coordinator_continue_mutex);
+  while (data->coordinator_wakeups == wakeups) {
+    pthread_cond_wait(&data->coordinator_continue_cond,
+        &data->coordinator_continue_mutex);
+  }
+  pthread_mutex_unlock(&data->coordinator_continue_mutex);
+}
+
+// The function and the tiles it computes are changed together under the
+// mutex, so that the kernel never pairs a function with the tiles of another
+void* acr_runtime_propose_function(
+    struct acr_runtime_data *data,
+    void *function,
+    const bool *computed_tiles) {
+  pthread_mutex_lock(&data->alternative_function_mutex);
+  void *previous = atomic_exchange_explicit(&data->alternative_function,
+      function, memory_order_relaxed);
+  data->proposed_computed_tiles = computed_tiles;
+  pthread_mutex_unlock(&data->alternative_function_mutex);
+  return previous;
+}
+
+void* acr_runtime_take_alternative_function(struct acr_runtime_data *data) {
+  pthread_mutex_lock(&data->alternative_function_mutex);
+  void *function = atomic_exchange_explicit(&data->alternative_function,
+      NULL, memory_order_relaxed);
+  if (function != NULL)
+    data->kernel_computed_tiles = data->proposed_computed_tiles;
+  pthread_mutex_unlock(&data->alternative_function_mutex);
+  return function;
+}
+
+void* acr_runtime_wait_alternative_function(struct acr_runtime_data *data) {
+  void *function;
+  pthread_mutex_lock(&data->alternative_function_mutex);
+  while ((function = atomic_exchange_explicit(&data->alternative_function,
+          NULL, memory_order_relaxed)) == NULL) {
+    pthread_cond_wait(&data->alternative_function_cond,
+        &data->alternative_function_mutex);
+  }
+  data->kernel_computed_tiles = data->proposed_computed_tiles;
+  pthread_mutex_unlock(&data->alternative_function_mutex);
+  return function;
+}
+
+void acr_runtime_wake_kernel(struct acr_runtime_data *data) {
+  pthread_mutex_lock(&data->alternative_function_mutex);
+  pthread_cond_signal(&data->alternative_function_cond);
+  pthread_mutex_unlock(&data->alternative_function_mutex);
+}
+
+void acr_runtime_record_kernel_time(
+    struct acr_runtime_data *data,
+    void *function,
+    double time) {
+  // The kernel thread is the only writer. The call count is published last
+  // so that the coordinator reads a time at least as recent.
+  size_t calls =
+    atomic_load_explicit(&data->timed_function_calls, memory_order_relaxed);
+  if (atomic_load_explicit(&data->timed_function, memory_order_relaxed) !=
+      function) {
+    calls = 0;
+    atomic_store_explicit(&data->timed_function_calls, 0,
+        memory_order_relaxed);
+    atomic_store_explicit(&data->timed_function, function,
+        memory_order_release);
+  }
+  // The first call of a function pays for its page faults and cold caches
+  calls += 1;
+  if (calls >= 2) {
+    double function_time = time;
+    if (calls > 2) {
+      function_time = atomic_load_explicit(&data->timed_function_time,
+          memory_order_relaxed) * 0.8 + time * 0.2;
+    }
+    atomic_store_explicit(&data->timed_function_time, function_time,
+        memory_order_relaxed);
+    if (function == data->original_function) {
+      atomic_store_explicit(&data->original_function_time, function_time,
+          memory_order_relaxed);
+    }
+  }
+  atomic_store_explicit(&data->timed_function_calls, calls,
+      memory_order_release);
+}
+
 size_t acr_runtime_get_num_monitor_dims(struct acr_runtime_data* data) {
   return data->num_monitor_dims;
 }
@@ -381,6 +766,133 @@ size_t acr_runtime_get_num_alternatives(struct acr_runtime_data*data) {
   return data->num_alternatives;
 }
 
+// The saved precision map starts with this header, the kernel bounds
+// (intmax_t[num_monitor_dimensions][2]) and the precision of each function
+static const char acr_precision_map_magic[8] = "ACRPMAP1";
+
+struct acr_precision_map_header {
+  char magic[sizeof(acr_precision_map_magic)];
+  uint64_t num_monitor_dimensions;
+  uint64_t grid_size;
+  uint64_t num_alternatives;
+  uint64_t total_functions;
+};
+
+static char* acr_static_data_precision_map_path(
+    const struct acr_runtime_data_static *static_data) {
+  const char *map_dir = getenv("ACR_PRECISION_MAP_DIR");
+  if (map_dir == NULL || map_dir[0] == '\0')
+    return NULL;
+  const char format[] = "%s/%s.precision";
+  int path_size =
+    snprintf(NULL, 0, format, map_dir, static_data->name) + 1;
+  char *path = malloc((size_t) path_size * sizeof(*path));
+  snprintf(path, (size_t) path_size, format, map_dir, static_data->name);
+  return path;
+}
+
+static void acr_static_data_precision_map_header(
+    const struct acr_runtime_data_static *static_data,
+    struct acr_precision_map_header *header) {
+  memset(header, 0, sizeof(*header));
+  memcpy(header->magic, acr_precision_map_magic, sizeof(header->magic));
+  header->num_monitor_dimensions = static_data->num_monitor_dimensions;
+  header->grid_size = static_data->grid_size;
+  header->num_alternatives = static_data->num_alternatives;
+  header->total_functions = static_data->total_functions;
+}
+
+// Keep the initial precision if there is no map or if it was saved for
+// another grid
+static void acr_static_data_load_precision_map(
+    struct acr_runtime_data_static *static_data) {
+  char *path = acr_static_data_precision_map_path(static_data);
+  if (path == NULL)
+    return;
+  FILE *map_file = fopen(path, "rb");
+  if (map_file == NULL) {
+    if (errno != ENOENT) {
+      fprintf(stderr,
+          "Warning: Cannot read the precision map \"%s\": %s\n",
+          path, strerror(errno));
+    }
+    free(path);
+    return;
+  }
+  struct acr_precision_map_header expected, header;
+  acr_static_data_precision_map_header(static_data, &expected);
+  const size_t num_dims = static_data->num_monitor_dimensions;
+  intmax_t (*min_max)[2] = malloc(num_dims * sizeof(*min_max));
+  unsigned char *precision =
+    malloc(static_data->total_functions * sizeof(*precision));
+  bool valid =
+    fread(&header, sizeof(header), 1, map_file) == 1 &&
+    memcmp(&header, &expected, sizeof(header)) == 0 &&
+    fread(min_max, sizeof(*min_max), num_dims, map_file) == num_dims &&
+    memcmp(min_max, static_data->min_max, num_dims * sizeof(*min_max)) == 0 &&
+    fread(precision, sizeof(*precision), static_data->total_functions,
+        map_file) == static_data->total_functions &&
+    fgetc(map_file) == EOF;
+  for (size_t i = 0; valid && i < static_data->total_functions; ++i) {
+    valid = precision[i] < static_data->num_alternatives;
+  }
+  fclose(map_file);
+  if (valid) {
+    memcpy(static_data->precision_array, precision,
+        static_data->total_functions * sizeof(*precision));
+  } else {
+    fprintf(stderr,
+        "Warning: The precision map \"%s\" does not match the kernel.\n"
+        "         Starting from the initial precision.\n", path);
+  }
+  free(precision);
+  free(min_max);
+  free(path);
+}
+
+// Written next to the map and renamed, a crash does not leave a partial map
+static void acr_static_data_save_precision_map(
+    const struct acr_runtime_data_static *static_data) {
+  char *path = acr_static_data_precision_map_path(static_data);
+  if (path == NULL)
+    return;
+  const char *map_dir = getenv("ACR_PRECISION_MAP_DIR");
+  if (mkdir(map_dir, 0700) == -1 && errno != EEXIST) {
+    fprintf(stderr,
+        "Warning: Cannot create \"%s\" from ACR_PRECISION_MAP_DIR environment"
+        " variable: %s\n"
+        "         The precision map is not saved.\n",
+        map_dir, strerror(errno));
+    free(path);
+    return;
+  }
+  size_t path_length = strlen(path);
+  char *temp_path = malloc((path_length + 5) * sizeof(*temp_path));
+  memcpy(temp_path, path, path_length * sizeof(*temp_path));
+  memcpy(temp_path + path_length, ".tmp", 5 * sizeof(*temp_path));
+  struct acr_precision_map_header header;
+  acr_static_data_precision_map_header(static_data, &header);
+  const size_t num_dims = static_data->num_monitor_dimensions;
+  FILE *map_file = fopen(temp_path, "wb");
+  bool written = map_file != NULL &&
+    fwrite(&header, sizeof(header), 1, map_file) == 1 &&
+    fwrite(static_data->min_max, sizeof(*static_data->min_max), num_dims,
+        map_file) == num_dims &&
+    fwrite(static_data->precision_array,
+        sizeof(*static_data->precision_array), static_data->total_functions,
+        map_file) == static_data->total_functions;
+  if (map_file != NULL && fclose(map_file) != 0)
+    written = false;
+  if (!written || rename(temp_path, path) == -1) {
+    fprintf(stderr,
+        "Warning: Cannot save the precision map \"%s\": %s\n",
+        path, strerror(errno));
+    unlink(temp_path);
+  }
+  free(temp_path);
+  free(path);
+}
+
 void acr_static_data_init_grid(struct acr_runtime_data_static *static_data) {
 
   static_data->total_functions = 1;
@@ -400,6 +912,7 @@ void acr_static_data_init_grid(struct acr_runtime_data_static *static_data) {
   for (size_t i = 0; i < static_data->total_functions; ++i) {
     static_data->precision_array[i] = 0;
   }
+  acr_static_data_load_precision_map(static_data);
 }
 
 void acr_runtime_data_specialize_alternative_domain(
@@ -459,8 +972,69 @@ void acr_runtime_data_specialize_alternative_domain(
   }
 }
 
+void acr_static_data_init_wavefronts(
+    struct acr_runtime_data_static *static_data,
+    size_t num_tiles) {
+  const size_t num_dims = static_data->num_monitor_dimensions;
+  const intmax_t grid_size = (intmax_t) static_data->grid_size;
+  const intmax_t *origins = static_data->tile_origins;
+
+  intmax_t *min_origin = malloc(num_dims * sizeof(*min_origin));
+  for (size_t i = 0; i < num_dims; ++i) {
+    min_origin[i] = INTMAX_MAX;
+    for (size_t tile = 0; tile < num_tiles; ++tile) {
+      if (origins[tile * num_dims + i] < min_origin[i])
+        min_origin[i] = origins[tile * num_dims + i];
+    }
+  }
+  size_t *wavefront = malloc(num_tiles * sizeof(*wavefront));
+  size_t max_wavefront = 0;
+  for (size_t tile = 0; tile < num_tiles; ++tile) {
+    wavefront[tile] = 0;
+    for (size_t i = 0; i < num_dims; ++i) {
+      wavefront[tile] +=
+        (size_t) ((origins[tile * num_dims + i] - min_origin[i]) / grid_size);
+    }
+    if (wavefront[tile] > max_wavefront)
+      max_wavefront = wavefront[tile];
+  }
+  free(min_origin);
+
+  // Counting sort
+  static_data->num_wavefronts = num_tiles > 0 ? max_wavefront + 1 : 0;
+  static_data->wavefront_start =
+    calloc(static_data->num_wavefronts + 1,
+        sizeof(*static_data->wavefront_start));
+  for (size_t tile = 0; tile < num_tiles; ++tile) {
+    static_data->wavefront_start[wavefront[tile] + 1] += 1;
+  }
+  for (size_t i = 0; i < static_data->num_wavefronts; ++i) {
+    static_data->wavefront_start[i+1] += static_data->wavefront_start[i];
+  }
+  size_t *next_position =
+    malloc((static_data->num_wavefronts + 1) * sizeof(*next_position));
+  memcpy(next_position, static_data->wavefront_start,
+      (static_data->num_wavefronts + 1) * sizeof(*next_position));
+  static_data->tile_order =
+    malloc((num_tiles + 1) * sizeof(*static_data->tile_order));
+  for (size_t tile = 0; tile < num_tiles; ++tile) {
+    static_data->tile_order[next_position[wavefront[tile]]++] = tile;
+  }
+  free(next_position);
+  free(wavefront);
+}
+
 void free_acr_static_data(struct acr_runtime_data_static *static_data) {
+  if (!static_data->is_uninitialized)
+    acr_static_data_save_precision_map(static_data);
   free(static_data->precision_array);
   free(static_data->min_max);
+  free(static_data->tile_origins);
+  free(static_data->tile_order);
+  free(static_data->wavefront_start);
+  static_data->tile_origins = NULL;
+  static_data->tile_order = NULL;
+  static_data->wavefront_start = NULL;
+  static_data->num_wavefronts = 0;
   static_data->is_uninitialized = 1;
 }
@@ -0,0 +1,63 @@
+/*
+ * Copyright (C) 2016 Maxime Schmitt
+ *
+ * ACR is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "acr/acr_runtime_function_pool.h"
+
+void acr_function_pool_init(struct acr_function_pool *pool,
+    size_t num_slots, size_t max_slots) {
+  pool->num_slots = num_slots;
+  pool->max_slots = max_slots < num_slots ? num_slots : max_slots;
+  pool->clock = 0;
+  // Allocated once for the maximal size, growing never moves the history
+  pool->last_used = calloc(pool->max_slots, sizeof(*pool->last_used));
+}
+
+void acr_function_pool_free(struct acr_function_pool *pool) {
+  free(pool->last_used);
+  pool->last_used = NULL;
+  pool->num_slots = 0;
+}
+
+void acr_function_pool_touch(struct acr_function_pool *pool, size_t slot) {
+  pool->clock += 1;
+  pool->last_used[slot] = pool->clock;
+}
+
+bool acr_function_pool_grow(struct acr_function_pool *pool) {
+  if (pool->num_slots == pool->max_slots)
+    return false;
+  pool->last_used[pool->num_slots] = 0;
+  pool->num_slots += 1;
+  return true;
+}
+
+size_t acr_function_pool_choose_slot(const struct acr_function_pool *pool,
+    size_t used_by_kernel, size_t proposed_to_kernel,
+    acr_function_pool_reusable reusable, void *user_data) {
+  size_t chosen = pool->num_slots;
+  uint64_t oldest_use = UINT64_MAX;
+  for (size_t i = 0; i < pool->num_slots; ++i) {
+    if (i == used_by_kernel || i == proposed_to_kernel)
+      continue;
+    if (pool->last_used[i] < oldest_use && reusable(i, user_data)) {
+      oldest_use = pool->last_used[i];
+      chosen = i;
+    }
+  }
+  return chosen;
+}
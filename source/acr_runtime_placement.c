@@ -0,0 +1,187 @@
+/*
+ * Copyright (C) 2016 Maxime Schmitt
+ *
+ * ACR is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+// cpu_set_t, sched_setaffinity and SCHED_IDLE
+#define _GNU_SOURCE
+
+#include "acr/acr_runtime_placement.h"
+
+#include <limits.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+
+static struct {
+  pthread_mutex_t mutex;
+  size_t num_cpus[acr_thread_num_classes];
+  int *cpus[acr_thread_num_classes];
+  int compile_nice;
+  bool compile_idle;
+} acr_placement = {
+  .mutex = PTHREAD_MUTEX_INITIALIZER,
+};
+
+static pthread_once_t acr_placement_once = PTHREAD_ONCE_INIT;
+
+static const char *const acr_placement_env[acr_thread_num_classes] = {
+  [acr_thread_monitor] = "ACR_MONITOR_CPUS",
+  [acr_thread_coordinator] = "ACR_COORDINATOR_CPUS",
+  [acr_thread_cloog] = "ACR_CLOOG_CPUS",
+  [acr_thread_compile] = "ACR_COMPILE_CPUS",
+};
+
+// Parse a CPU list like "0-3,8", returns the number of CPUs or 0 if invalid
+static size_t acr_parse_cpu_list(const char *list, int **cpus) {
+  size_t num_cpus = 0, max_cpus = 8;
+  *cpus = malloc(max_cpus * sizeof(**cpus));
+  const char *position = list;
+  do {
+    char *end;
+    long first = strtol(position, &end, 10);
+    if (end == position || first < 0 || first > INT_MAX)
+      goto bad_list;
+    long last = first;
+    position = end;
+    if (*position == '-') {
+      last = strtol(position + 1, &end, 10);
+      if (end == position + 1 || last < first || last > INT_MAX)
+        goto bad_list;
+      position = end;
+    }
+    for (long cpu = first; cpu <= last; ++cpu) {
+      if (num_cpus == max_cpus) {
+        max_cpus *= 2;
+        *cpus = realloc(*cpus, max_cpus * sizeof(**cpus));
+      }
+      (*cpus)[num_cpus++] = (int) cpu;
+    }
+  } while (*position++ == ',');
+  if (position[-1] == '\0')
+    return num_cpus;
+bad_list:
+  free(*cpus);
+  *cpus = NULL;
+  return 0;
+}
+
+static void acr_placement_init_from_env(void) {
+  for (size_t i = 0; i < acr_thread_num_classes; ++i) {
+    const char *cpus_env = getenv(acr_placement_env[i]);
+    if (cpus_env == NULL)
+      continue;
+    acr_placement.num_cpus[i] =
+      acr_parse_cpu_list(cpus_env, &acr_placement.cpus[i]);
+    if (acr_placement.num_cpus[i] == 0) {
+      fprintf(stderr,
+          "Warning: Bad value \"%s\" in %s environment variable.\n"
+          "         The threads are not pinned.\n",
+          cpus_env, acr_placement_env[i]);
+    }
+  }
+  const char *nice_env = getenv("ACR_COMPILE_NICE");
+  if (nice_env != NULL) {
+    int nice_value;
+    if (strcmp(nice_env, "idle") == 0) {
+      acr_placement.compile_idle = true;
+    } else if (sscanf(nice_env, "%d", &nice_value) == 1) {
+      acr_placement.compile_nice = nice_value;
+    } else {
+      fprintf(stderr,
+          "Warning: Bad value \"%s\" in ACR_COMPILE_NICE environment"
+          " variable.\n"
+          "         Default to the process priority.\n", nice_env);
+    }
+  }
+}
+
+void acr_runtime_set_thread_cpus(
+    enum acr_thread_class thread_class,
+    size_t num_cpus,
+    const int *cpus) {
+  pthread_once(&acr_placement_once, acr_placement_init_from_env);
+  pthread_mutex_lock(&acr_placement.mutex);
+  free(acr_placement.cpus[thread_class]);
+  acr_placement.cpus[thread_class] = NULL;
+  acr_placement.num_cpus[thread_class] = num_cpus;
+  if (num_cpus > 0) {
+    acr_placement.cpus[thread_class] =
+      malloc(num_cpus * sizeof(*acr_placement.cpus[thread_class]));
+    memcpy(acr_placement.cpus[thread_class], cpus,
+        num_cpus * sizeof(*acr_placement.cpus[thread_class]));
+  }
+  pthread_mutex_unlock(&acr_placement.mutex);
+}
+
+void acr_runtime_set_compile_threads_priority(int nice_value, bool idle) {
+  pthread_once(&acr_placement_once, acr_placement_init_from_env);
+  pthread_mutex_lock(&acr_placement.mutex);
+  acr_placement.compile_nice = nice_value;
+  acr_placement.compile_idle = idle;
+  pthread_mutex_unlock(&acr_placement.mutex);
+}
+
+// On Linux a thread id can be given where a process id is expected
+static void acr_place(enum acr_thread_class thread_class, pid_t id) {
+  pthread_once(&acr_placement_once, acr_placement_init_from_env);
+  pthread_mutex_lock(&acr_placement.mutex);
+  const size_t num_cpus = acr_placement.num_cpus[thread_class];
+  if (num_cpus > 0) {
+    // The CPUs given through acr_runtime_set_thread_cpus are not checked,
+    // negative ones are ignored
+    size_t max_cpu = 0;
+    for (size_t i = 0; i < num_cpus; ++i) {
+      const int cpu = acr_placement.cpus[thread_class][i];
+      if (cpu > 0 && (size_t) cpu > max_cpu)
+        max_cpu = (size_t) cpu;
+    }
+    cpu_set_t *cpu_set = CPU_ALLOC(max_cpu + 1);
+    const size_t set_size = CPU_ALLOC_SIZE(max_cpu + 1);
+    CPU_ZERO_S(set_size, cpu_set);
+    for (size_t i = 0; i < num_cpus; ++i) {
+      const int cpu = acr_placement.cpus[thread_class][i];
+      if (cpu >= 0)
+        CPU_SET_S((size_t) cpu, set_size, cpu_set);
+    }
+    if (sched_setaffinity(id, set_size, cpu_set) == -1)
+      perror("sched_setaffinity");
+    CPU_FREE(cpu_set);
+  }
+  if (thread_class == acr_thread_compile) {
+    if (acr_placement.compile_idle) {
+      struct sched_param param = { .sched_priority = 0 };
+      if (sched_setscheduler(id, SCHED_IDLE, &param) == -1)
+        perror("sched_setscheduler");
+    }
+    if (acr_placement.compile_nice != 0 &&
+        setpriority(PRIO_PROCESS, (id_t) id, acr_placement.compile_nice) == -1)
+      perror("setpriority");
+  }
+  pthread_mutex_unlock(&acr_placement.mutex);
+}
+
+void acr_runtime_place_thread(enum acr_thread_class thread_class) {
+  acr_place(thread_class, (pid_t) syscall(SYS_gettid));
+}
+
+void acr_runtime_place_compile_process(pid_t pid) {
+  acr_place(acr_thread_compile, pid);
+}
@@ -0,0 +1,149 @@
+/*
+ * Copyright (C) 2016 Maxime Schmitt
+ *
+ * ACR is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "acr/acr_runtime_queue.h"
+
+#include <stdint.h>
+
+// Each cell sequence number tells the position it can be written (sequence ==
+// position) or read (sequence == position + 1) at. A producer or a consumer
+// reserves a position with a CAS and publishes the cell with its sequence.
+
+void acr_queue_init(struct acr_queue *queue, size_t capacity) {
+  size_t num_cells = 2;
+  while (num_cells < capacity)
+    num_cells *= 2;
+  queue->mask = num_cells - 1;
+  queue->cells = malloc(num_cells * sizeof(*queue->cells));
+  for (size_t i = 0; i < num_cells; ++i) {
+    atomic_init(&queue->cells[i].sequence, i);
+    queue->cells[i].item = NULL;
+  }
+  atomic_init(&queue->enqueue_position, 0);
+  atomic_init(&queue->dequeue_position, 0);
+  atomic_init(&queue->num_sleeping, 0);
+  atomic_init(&queue->closed, false);
+  pthread_mutex_init(&queue->sleep_mutex, NULL);
+  pthread_cond_init(&queue->not_empty, NULL);
+}
+
+void acr_queue_free(struct acr_queue *queue) {
+  free(queue->cells);
+  queue->cells = NULL;
+  pthread_mutex_destroy(&queue->sleep_mutex);
+  pthread_cond_destroy(&queue->not_empty);
+}
+
+bool acr_queue_push(struct acr_queue *queue, void *item) {
+  struct acr_queue_cell *cell;
+  size_t position =
+    atomic_load_explicit(&queue->enqueue_position, memory_order_relaxed);
+  for (;;) {
+    cell = &queue->cells[position & queue->mask];
+    const size_t sequence =
+      atomic_load_explicit(&cell->sequence, memory_order_acquire);
+    const intptr_t difference = (intptr_t) sequence - (intptr_t) position;
+    if (difference == 0) {
+      if (atomic_compare_exchange_weak_explicit(&queue->enqueue_position,
+            &position, position + 1,
+            memory_order_relaxed, memory_order_relaxed))
+        break;
+    } else if (difference < 0) {
+      return false; // Full
+    } else {
+      position =
+        atomic_load_explicit(&queue->enqueue_position, memory_order_relaxed);
+    }
+  }
+  cell->item = item;
+  atomic_store_explicit(&cell->sequence, position + 1, memory_order_release);
+
+  // Pairs with the fence of acr_queue_pop_wait: either the consumer sees the
+  // element or the producer sees the consumer sleeping
+  atomic_thread_fence(memory_order_seq_cst);
+  if (atomic_load_explicit(&queue->num_sleeping, memory_order_relaxed) > 0) {
+    pthread_mutex_lock(&queue->sleep_mutex);
+    pthread_cond_signal(&queue->not_empty);
+    pthread_mutex_unlock(&queue->sleep_mutex);
+  }
+  return true;
+}
+
+bool acr_queue_try_pop(struct acr_queue *queue, void **item) {
+  struct acr_queue_cell *cell;
+  size_t position =
+    atomic_load_explicit(&queue->dequeue_position, memory_order_relaxed);
+  for (;;) {
+    cell = &queue->cells[position & queue->mask];
+    const size_t sequence =
+      atomic_load_explicit(&cell->sequence, memory_order_acquire);
+    const intptr_t difference =
+      (intptr_t) sequence - (intptr_t) (position + 1);
+    if (difference == 0) {
+      if (atomic_compare_exchange_weak_explicit(&queue->dequeue_position,
+            &position, position + 1,
+            memory_order_relaxed, memory_order_relaxed))
+        break;
+    } else if (difference < 0) {
+      return false; // Empty
+    } else {
+      position =
+        atomic_load_explicit(&queue->dequeue_position, memory_order_relaxed);
+    }
+  }
+  *item = cell->item;
+  atomic_store_explicit(&cell->sequence, position + queue->mask + 1,
+      memory_order_release);
+  return true;
+}
+
+static size_t acr_queue_pop_some(struct acr_queue *queue, void **items,
+    size_t max_items) {
+  size_t num_items = 0;
+  while (num_items < max_items &&
+      acr_queue_try_pop(queue, &items[num_items]))
+    num_items += 1;
+  return num_items;
+}
+
+size_t acr_queue_pop_wait(struct acr_queue *queue, void **items,
+    size_t max_items) {
+  if (atomic_load_explicit(&queue->closed, memory_order_acquire))
+    return 0;
+  size_t num_items = acr_queue_pop_some(queue, items, max_items);
+  if (num_items > 0)
+    return num_items;
+
+  pthread_mutex_lock(&queue->sleep_mutex);
+  atomic_fetch_add_explicit(&queue->num_sleeping, 1, memory_order_relaxed);
+  atomic_thread_fence(memory_order_seq_cst);
+  while (!atomic_load_explicit(&queue->closed, memory_order_acquire) &&
+      (num_items = acr_queue_pop_some(queue, items, max_items)) == 0) {
+    pthread_cond_wait(&queue->not_empty, &queue->sleep_mutex);
+  }
+  atomic_fetch_sub_explicit(&queue->num_sleeping, 1, memory_order_relaxed);
+  pthread_mutex_unlock(&queue->sleep_mutex);
+  return num_items;
+}
+
+void acr_queue_close(struct acr_queue *queue) {
+  pthread_mutex_lock(&queue->sleep_mutex);
+  atomic_store_explicit(&queue->closed, true, memory_order_release);
+  pthread_cond_broadcast(&queue->not_empty);
+  pthread_mutex_unlock(&queue->sleep_mutex);
+}
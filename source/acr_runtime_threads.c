@@ -27,8 +27,12 @@
 #include <stdatomic.h>
 
 #include "acr/acr_runtime_build.h"
+#include "acr/acr_runtime_cache.h"
 #include "acr/acr_runtime_code_generation.h"
+#include "acr/acr_runtime_function_pool.h"
 #include "acr/acr_runtime_data.h"
+#include "acr/acr_runtime_placement.h"
+#include "acr/acr_runtime_queue.h"
 #include "acr/acr_runtime_verify.h"
 #include "acr/acr_stats.h"
 
@@ -38,6 +42,30 @@ static void* acr_runtime_compile_thread(void* in_data);
 
 static void* acr_cloog_generate_code_from_alt(void* in_data);
 
+static const size_t acr_version_cache_history = 16;
+
+static const size_t acr_cc_max_attempts = 2;
+
+static const size_t acr_compile_max_batch = 8;
+
+#ifdef TCC_PRESENT
+// Expected fraction of the time of a TCC version saved by its cc version.
+// TCC does not optimize, it keeps every variable in memory and does not
+// vectorize, so the loop nests it compiles commonly run at least twice as
+// slow as with cc -O2. Only used to decide when to promote, the cc version
+// is then timed against the original kernel like any other.
+static const double acr_cc_expected_gain = 0.5;
+#endif
+
+// Calls of a version measured before comparing it to the original kernel
+static const size_t acr_timing_min_calls = 4;
+
+// A version must be this much slower than the original kernel to be dropped
+static const double acr_timing_tolerance = 0.05;
+
+static const char acr_required_definitions_include[] =
+  "#include \"acr_required_definitions.h\"\n";
+
 enum acr_avaliable_function_type {
   acr_function_empty,
   acr_function_proposed_cloog_gen,
@@ -48,7 +76,10 @@ enum acr_avaliable_function_type {
 #ifdef TCC_PRESENT
   acr_function_tcc_in_memory,
   acr_function_tcc_and_shared,
+  acr_function_tcc_only,
+  acr_function_proposed_promotion,
 #endif
+  acr_function_poisoned,
 };
 
 enum acr_kernel_function_type {
@@ -61,30 +92,39 @@ enum acr_kernel_function_type {
   acr_kernel_function_using_cc,
 };
 
-struct acr_avaliable_functions {
-  size_t total_functions;
-  struct func_value {
+struct func_value {
 #ifdef TCC_PRESENT
-    void *tcc_function;
+  void *tcc_function;
 #endif
-    void *cc_function;
-    unsigned char *monitor_result;
-    unsigned char *monitor_untouched;
-    FILE *memstream;
-    size_t sizeof_string;
-    char *generated_code;
+  void *cc_function;
+  unsigned char *monitor_result;
+  unsigned char *monitor_untouched;
+  bool *computed_tiles; // Outermost tile indices computed by the version
+  FILE *memstream;
+  size_t sizeof_string;
+  char *generated_code;
+  struct acr_version_cache_entry *version;
+  // Compiled code of a version not in the cache
+  void *uncached_code;
+  acr_code_unload unload_uncached_code;
+#ifdef TCC_PRESENT
+  struct {
     struct {
-      struct {
-        void *dlhandle;
-      } shared_obj_lib;
+      TCCState *state;
+    } tcc;
+  } compiler_specific;
+#endif
+  bool slower_than_original;
+  atomic_bool in_cloog_queue;
 #ifdef TCC_PRESENT
-      struct {
-        TCCState *state;
-      } tcc;
+  size_t adopted_at_call;
 #endif
-    } compiler_specific;
-    _Atomic enum acr_avaliable_function_type type;
-  } *value;
+  _Atomic enum acr_avaliable_function_type type;
+};
+
+struct acr_avaliable_functions {
+  struct acr_function_pool pool;
+  size_t monitor_total_size;
   struct func_value **function_priority;
 };
 
@@ -94,75 +134,146 @@ struct acr_monitoring_shared {
 };
 
 struct acr_monitoring_computation {
-  void (*monitoring_function)(unsigned char*);
+  void (*monitoring_function)(unsigned char*, long, long);
   size_t monitor_result_size;
+  size_t num_threads;
+  long num_outer_tiles;
+  atomic_bool *dirty_tracking;
+  atomic_bool *dirty_outer_tiles;
 #ifdef ACR_STATS_ENABLED
   size_t num_mesurement;
   double total_time;
 #endif
   struct acr_runtime_kernel_info *kernel_info;
   struct acr_monitoring_shared *shared_buffer;
-  atomic_flag end_yourself;
+  atomic_bool end_yourself;
   pthread_cond_t *sleep_cond;
-  pthread_cond_t *coordinator_continue_cond;
+  pthread_mutex_t *sleep_mutex;
+  atomic_bool *sleeping;
+  struct acr_runtime_data *coordinator;
 };
 
 struct acr_runtime_threads_cloog_gencode {
   size_t thread_num;
   size_t num_threads;
-  size_t num_threads_compiling;
-  struct func_value *where_to_add;
+  struct acr_queue jobs;
   struct acr_runtime_data *rdata;
+  struct acr_version_cache *version_cache;
 #ifdef ACR_STATS_ENABLED
   size_t num_mesurement;
   double total_time;
 #endif
   pthread_mutex_t mutex;
-  pthread_cond_t compiler_thread_sleep;
-  pthread_cond_t coordinator_sleep;
-  pthread_cond_t *coordinator_continue_cond;
-  bool generate_function;
-  volatile bool end_yourself;
 };
 
 struct acr_runtime_threads_compile_data {
   size_t num_threads;
-  size_t num_threads_compiling;
-  struct func_value *where_to_add;
+  struct acr_queue pending;
   size_t num_cflags;
-  char **cflags;
+  char ***cflags; // One option array per compile thread
+  const char *cache_dir;
+  struct acr_version_cache *version_cache;
+  struct acr_compile_server *compile_servers;
+  size_t next_thread_num;
 #ifdef ACR_STATS_ENABLED
   size_t num_mesurement;
   double total_time;
   size_t num_tcc_mesurement;
   double total_tcc_time;
+  size_t num_cc_failures;
+  size_t num_tcc_failures;
+  size_t num_degraded_versions;
+  size_t num_poisoned_versions;
 #endif
+  bool eager_cc;
+  double cc_time_estimate;
   pthread_mutex_t mutex;
-  pthread_cond_t compiler_thread_sleep;
-  pthread_cond_t coordinator_sleep;
-  pthread_cond_t *coordinator_continue_cond;
-  bool compile_something;
-  volatile bool end_yourself;
+  struct acr_runtime_data *coordinator;
 };
 
 #ifdef TCC_PRESENT
 struct acr_runtime_threads_compile_tcc {
-  struct func_value *where_to_add;
+  struct func_value **batch;
+  size_t batch_size;
 #ifdef ACR_STATS_ENABLED
   size_t num_mesurement;
   double total_time;
+  size_t num_failures;
 #endif
   pthread_mutex_t mutex;
   pthread_cond_t waking_up;
-  pthread_cond_t *coordinator_continue_cond;
+  struct acr_runtime_data *coordinator;
+  struct acr_version_cache *version_cache;
   bool compile_something;
   volatile bool end_yourself;
 };
 #endif
 
+struct acr_monitoring_workers {
+  void (*monitoring_function)(unsigned char*, long, long);
+  unsigned char *monitor_result;
+  const unsigned char *dirty_outer_tiles;
+  size_t num_threads;
+  long num_outer_tiles;
+  pthread_barrier_t start_barrier;
+  pthread_barrier_t end_barrier;
+  bool end_yourself;
+};
+
+struct acr_monitoring_worker_data {
+  struct acr_monitoring_workers *workers;
+  size_t worker_num;
+};
+
+// Each worker scans a contiguous range of the outermost tile dimension and
+// only writes the part of monitor_result matching its range. When the dirty
+// tiles are known, only the dirty runs of the range are scanned.
+static void acr_monitoring_scan_slice(
+    struct acr_monitoring_workers *workers,
+    size_t worker_num) {
+  const long num_threads = (long) workers->num_threads;
+  const long worker = (long) worker_num;
+  const long first = workers->num_outer_tiles * worker / num_threads;
+  const long last = workers->num_outer_tiles * (worker + 1) / num_threads;
+  const unsigned char *const dirty = workers->dirty_outer_tiles;
+  if (dirty == NULL) {
+    if (first < last)
+      workers->monitoring_function(workers->monitor_result, first, last);
+    return;
+  }
+  long run_start = first;
+  while (run_start < last) {
+    while (run_start < last && !dirty[run_start])
+      ++run_start;
+    long run_end = run_start;
+    while (run_end < last && dirty[run_end])
+      ++run_end;
+    if (run_start < run_end)
+      workers->monitoring_function(workers->monitor_result, run_start, run_end);
+    run_start = run_end;
+  }
+}
+
+static void* acr_runtime_monitoring_worker(void *in_data) {
+  struct acr_monitoring_worker_data *const worker_data =
+    (struct acr_monitoring_worker_data*) in_data;
+  struct acr_monitoring_workers *const workers = worker_data->workers;
+  acr_runtime_place_thread(acr_thread_monitor);
+
+  while (true) {
+    pthread_barrier_wait(&workers->start_barrier);
+    if (workers->end_yourself)
+      break;
+    acr_monitoring_scan_slice(workers, worker_data->worker_num);
+    pthread_barrier_wait(&workers->end_barrier);
+  }
+  pthread_exit(NULL);
+}
+
 static void* acr_runtime_monitoring_function(void *in_data) {
   struct acr_monitoring_computation * const input_data =
     (struct acr_monitoring_computation*) in_data;
+  acr_runtime_place_thread(acr_thread_monitor);
 
 #ifdef ACR_STATS_ENABLED
   double total_time = 0.;
@@ -175,16 +286,46 @@ static void* acr_runtime_monitoring_function(void *in_data) {
     malloc(input_data->monitor_result_size * sizeof(*monitor_result));
   unsigned char *expected_value = monitor_result;
 
-  void (*const monitoring_function)(unsigned char*) =
-    input_data->monitoring_function;
+  // The monitor thread is the worker 0 and scans the first slice itself
+  struct acr_monitoring_workers workers = {
+    .monitoring_function = input_data->monitoring_function,
+    .monitor_result = NULL,
+    .dirty_outer_tiles = NULL,
+    .num_threads = input_data->num_threads,
+    .num_outer_tiles = input_data->num_outer_tiles,
+    .end_yourself = false,
+  };
+  const size_t num_helpers = workers.num_threads - 1;
+  pthread_t *helper_threads = NULL;
+  struct acr_monitoring_worker_data *helper_data = NULL;
+  if (num_helpers > 0) {
+    pthread_barrier_init(&workers.start_barrier, NULL,
+        (unsigned int) workers.num_threads);
+    pthread_barrier_init(&workers.end_barrier, NULL,
+        (unsigned int) workers.num_threads);
+    helper_threads = malloc(num_helpers * sizeof(*helper_threads));
+    helper_data = malloc(num_helpers * sizeof(*helper_data));
+    for (size_t i = 0; i < num_helpers; ++i) {
+      helper_data[i].workers = &workers;
+      helper_data[i].worker_num = i + 1;
+      pthread_create(&helper_threads[i], NULL, acr_runtime_monitoring_worker,
+          (void*) &helper_data[i]);
+    }
+  }
+
+  // Last scan result, used for the tiles that are not dirty
+  const size_t num_outer_tiles = (size_t) input_data->num_outer_tiles;
+  unsigned char *previous_result =
+    malloc(input_data->monitor_result_size * sizeof(*previous_result));
+  unsigned char *dirty_snapshot =
+    malloc(num_outer_tiles * sizeof(*dirty_snapshot));
+  bool has_previous_result = false;
 
   double compute_time;
   size_t last_kernel_id = 0;
   acr_time t1;
   acr_get_current_time(&t1);
-  pthread_mutex_t mut;
-  pthread_mutex_init(&mut, NULL);
-  while(atomic_flag_test_and_set_explicit(&input_data->end_yourself, memory_order_relaxed)) {
+  while(!atomic_load_explicit(&input_data->end_yourself, memory_order_relaxed)) {
 
     struct acr_runtime_kernel_info kinfo = *kernel_info;
     if (last_kernel_id != kinfo.num_calls) {
@@ -193,7 +334,29 @@ static void* acr_runtime_monitoring_function(void *in_data) {
       acr_time tstart;
       acr_get_current_time(&tstart);
 
-      monitoring_function(monitor_result);
+      for (size_t i = 0; i < num_outer_tiles; ++i) {
+        dirty_snapshot[i] = atomic_exchange_explicit(
+            &input_data->dirty_outer_tiles[i], false, memory_order_acquire);
+      }
+      if (has_previous_result && atomic_load_explicit(
+            input_data->dirty_tracking, memory_order_relaxed)) {
+        memcpy(monitor_result, previous_result,
+            input_data->monitor_result_size);
+        workers.dirty_outer_tiles = dirty_snapshot;
+      } else {
+        workers.dirty_outer_tiles = NULL;
+      }
+
+      workers.monitor_result = monitor_result;
+      if (num_helpers > 0) {
+        pthread_barrier_wait(&workers.start_barrier);
+        acr_monitoring_scan_slice(&workers, 0);
+        pthread_barrier_wait(&workers.end_barrier);
+      } else {
+        acr_monitoring_scan_slice(&workers, 0);
+      }
+      memcpy(previous_result, monitor_result, input_data->monitor_result_size);
+      has_previous_result = true;
 
       acr_get_current_time(&t1);
       compute_time = acr_difftime(tstart, t1);
@@ -219,17 +382,39 @@ static void* acr_runtime_monitoring_function(void *in_data) {
             &input_data->shared_buffer->current_valid_computation,
             monitor_result,
             memory_order_release);
-        pthread_cond_signal(input_data->coordinator_continue_cond);
         expected_value = monitor_result;
         monitor_result = old;
       }
+      acr_runtime_wake_coordinator(input_data->coordinator);
     } else {
-      pthread_mutex_lock(&mut);
-      pthread_cond_wait(input_data->sleep_cond, &mut);
-      pthread_mutex_unlock(&mut);
+      pthread_mutex_lock(input_data->sleep_mutex);
+      atomic_store_explicit(input_data->sleeping, true, memory_order_relaxed);
+      // Pairs with the fence of acr_runtime_wake_monitor, the kernel only
+      // signals a sleeping monitor
+      atomic_thread_fence(memory_order_seq_cst);
+      if (kernel_info->num_calls == last_kernel_id &&
+          !atomic_load_explicit(&input_data->end_yourself,
+            memory_order_relaxed))
+        pthread_cond_wait(input_data->sleep_cond, input_data->sleep_mutex);
+      atomic_store_explicit(input_data->sleeping, false, memory_order_relaxed);
+      pthread_mutex_unlock(input_data->sleep_mutex);
+    }
+  }
+
+  if (num_helpers > 0) {
+    workers.end_yourself = true;
+    pthread_barrier_wait(&workers.start_barrier);
+    for (size_t i = 0; i < num_helpers; ++i) {
+      pthread_join(helper_threads[i], NULL);
     }
+    pthread_barrier_destroy(&workers.start_barrier);
+    pthread_barrier_destroy(&workers.end_barrier);
+    free(helper_threads);
+    free(helper_data);
   }
 
+  free(previous_result);
+  free(dirty_snapshot);
   free(monitor_result);
   if (input_data->shared_buffer->current_valid_computation) {
     free(input_data->shared_buffer->current_valid_computation);
@@ -245,6 +430,161 @@ static void* acr_runtime_monitoring_function(void *in_data) {
   pthread_exit(NULL);
 }
 
+#ifdef TCC_PRESENT
+static void acr_unload_tcc_state(void *state) {
+  tcc_delete((TCCState *) state);
+}
+#endif
+
+#ifdef MIR_PRESENT
+static void acr_unload_mir_context(void *context) {
+  acr_free_mir_context((MIR_context_t) context);
+}
+#endif
+
+// The cache owns the code of a cached version, the slot owns the code of a
+// version left out of the full cache
+static void acr_slot_set_compiled_code(
+    struct acr_version_cache *version_cache,
+    struct func_value *slot,
+    void *code_handle,
+    acr_code_unload unload_code,
+    void *function) {
+  if (slot->version) {
+    slot->cc_function = acr_version_cache_set_function(version_cache,
+        slot->version, acr_version_tier_optimized, code_handle, unload_code,
+        function);
+  } else {
+    slot->uncached_code = code_handle;
+    slot->unload_uncached_code = unload_code;
+    slot->cc_function = function;
+  }
+}
+
+static void acr_slot_release_version(
+    struct acr_version_cache *version_cache,
+    struct func_value *slot) {
+  acr_version_cache_release(version_cache, slot->version);
+  slot->version = NULL;
+  if (slot->uncached_code) {
+    slot->unload_uncached_code(slot->uncached_code);
+    slot->uncached_code = NULL;
+  }
+}
+
+static struct func_value* acr_function_pool_new_slot(
+    size_t monitor_total_size) {
+  struct func_value *slot = malloc(sizeof(*slot));
+#ifdef TCC_PRESENT
+  slot->compiler_specific.tcc.state = NULL;
+#endif
+  slot->version = NULL;
+  slot->uncached_code = NULL;
+  slot->computed_tiles = NULL;
+  slot->slower_than_original = false;
+  atomic_init(&slot->in_cloog_queue, false);
+  atomic_store(&slot->type, acr_function_empty);
+  slot->monitor_result =
+    malloc(monitor_total_size * sizeof(*slot->monitor_result));
+  slot->monitor_untouched =
+    malloc(monitor_total_size * sizeof(*slot->monitor_untouched));
+  slot->memstream = open_memstream(&slot->generated_code,
+      &slot->sizeof_string);
+  return slot;
+}
+
+static void acr_function_pool_free_slot(
+    struct func_value *slot,
+    struct acr_version_cache *version_cache) {
+  fclose(slot->memstream);
+  free(slot->generated_code);
+  free(slot->monitor_result);
+  free(slot->monitor_untouched);
+  free(slot->computed_tiles);
+  acr_slot_release_version(version_cache, slot);
+#ifdef TCC_PRESENT
+  if (slot->compiler_specific.tcc.state)
+    tcc_delete(slot->compiler_specific.tcc.state);
+#endif
+  free(slot);
+}
+
+
+static void acr_coordinator_sleep(struct acr_runtime_data *const init_data) {
+  acr_runtime_wait_coordinator_wakeup(init_data,
+      acr_runtime_coordinator_wakeups(init_data));
+}
+
+// The queues can hold the whole pool and a slot is never queued twice, a
+// full queue means the slot would be lost
+static void acr_queue_push_slot(struct acr_queue *queue,
+    struct func_value *slot) {
+  if (!acr_queue_push(queue, slot)) {
+    fprintf(stderr, "[ACR] Error: a function slot was queued twice\n");
+    abort();
+  }
+}
+
+// With the incremental clause, the kernel reports as modified the rows of
+// tiles where its version computes something. The slot is neither used nor
+// proposed when its generation finishes, the kernel never reads this while
+// it is written.
+static void acr_slot_set_computed_tiles(
+    struct func_value *slot,
+    struct acr_runtime_data *const init_data) {
+  if (!init_data->incremental_monitoring)
+    return;
+  const size_t num_outer_tiles = init_data->monitor_dim_max[0];
+  const size_t outer_tile_size = init_data->monitor_total_size /
+    num_outer_tiles;
+  if (slot->computed_tiles == NULL)
+    slot->computed_tiles =
+      malloc(num_outer_tiles * sizeof(*slot->computed_tiles));
+  for (size_t i = 0; i < num_outer_tiles; ++i) {
+    slot->computed_tiles[i] = false;
+    for (size_t j = i * outer_tile_size;
+        !slot->computed_tiles[i] && j < (i + 1) * outer_tile_size; ++j) {
+      slot->computed_tiles[i] =
+        init_data->alternative_from_val(slot->monitor_result[j])->type !=
+        acr_runtime_alternative_zero_computation;
+    }
+  }
+}
+
+static void acr_compile_queue_slot(
+    enum acr_avaliable_function_type type,
+    struct func_value *slot,
+    struct acr_runtime_threads_compile_data *const compile_threads_data) {
+  atomic_store_explicit(&slot->type, type, memory_order_relaxed);
+  acr_queue_push_slot(&compile_threads_data->pending, slot);
+}
+
+#ifdef TCC_PRESENT
+// A TCC version is compiled with cc once it lived long enough, or once the
+// time it would save over the same number of calls pays for the compilation.
+static bool acr_tcc_version_worth_promotion(
+    const struct func_value *slot,
+    struct acr_runtime_data *const init_data,
+    struct acr_runtime_threads_compile_data *const compile_threads_data) {
+  const size_t calls = init_data->kernel_info->num_calls - slot->adopted_at_call;
+  if (calls >= init_data->promotion_calls)
+    return true;
+  // The kernel times the TCC version since it was proposed
+  if (atomic_load_explicit(&init_data->timed_function, memory_order_acquire)
+      != slot->tcc_function ||
+      atomic_load_explicit(&init_data->timed_function_calls,
+        memory_order_acquire) < 2)
+    return false;
+  pthread_mutex_lock(&compile_threads_data->mutex);
+  const double cc_time = compile_threads_data->cc_time_estimate;
+  pthread_mutex_unlock(&compile_threads_data->mutex);
+  const double projected_savings = (double) calls *
+    atomic_load_explicit(&init_data->timed_function_time,
+        memory_order_relaxed) * acr_cc_expected_gain;
+  return cc_time > 0. && projected_savings > cc_time;
+}
+#endif
+
 static void acr_valid_function_switch_to(enum acr_avaliable_function_type type,
     enum acr_kernel_function_type *function_used_by_kernel_type,
     size_t *restrict function_used_by_kernel,
@@ -254,42 +594,52 @@ static void acr_valid_function_switch_to(enum acr_avaliable_function_type type,
     struct acr_avaliable_functions *const functions,
     struct acr_runtime_threads_compile_data *const compile_threads_data) {
 
+  if (functions->function_priority[most_recent_function]->
+      slower_than_original) {
+    // The original kernel keeps running until a new monitoring. In optimal
+    // generation mode the kernel is waiting for it.
+    if (init_data->generate_optimum_function) {
+      acr_runtime_propose_function(init_data, init_data->original_function,
+          NULL);
+    } else {
+      acr_coordinator_sleep(init_data);
+    }
+    return;
+  }
+
   switch(type) {
     case acr_function_finished_cloog_gen:  // missing C compilation
       /*fprintf(stderr, "Compiling %zu\n", most_recent_function);*/
-      pthread_mutex_lock(&compile_threads_data->mutex);
-      while((compile_threads_data->compile_something &&
-            compile_threads_data->where_to_add !=
-            functions->function_priority[most_recent_function]) ||
-          compile_threads_data->num_threads ==
-          compile_threads_data->num_threads_compiling) {
-        pthread_cond_wait(&compile_threads_data->coordinator_sleep,
-            &compile_threads_data->mutex);
-      }
-      atomic_store_explicit(
-          &functions->function_priority[most_recent_function]->type,
-          acr_function_proposed_compilation,
-          memory_order_relaxed);
-      compile_threads_data->compile_something = true;
-      compile_threads_data->where_to_add =
-        functions->function_priority[most_recent_function];
-      pthread_cond_signal(&compile_threads_data->compiler_thread_sleep);
-      pthread_mutex_unlock(&compile_threads_data->mutex);
+      acr_slot_set_computed_tiles(
+          functions->function_priority[most_recent_function], init_data);
+      // Queue the slot, a compile thread compiles the pending slots together
+      acr_compile_queue_slot(acr_function_proposed_compilation,
+          functions->function_priority[most_recent_function],
+          compile_threads_data);
       break;
     case acr_function_proposed_compilation: // - Waiting compilation
       break;
 #ifdef TCC_PRESENT
+    case acr_function_proposed_promotion: // Waiting cc compilation
+      acr_coordinator_sleep(init_data);
+      break;
+    case acr_function_tcc_only: // Waiting promotion to cc
     case acr_function_tcc_in_memory: // Fast compilation finished
       if (*function_used_by_kernel_type == acr_kernel_function_initial) {
         /*fprintf(stderr, "Propose tcc %zu\n", most_recent_function);*/
-        atomic_store_explicit(&init_data->alternative_function,
-            functions->function_priority[most_recent_function]->tcc_function,
+        // Its time tells when the cc version is worth compiling
+        atomic_store_explicit(&init_data->time_kernel_calls, true,
             memory_order_relaxed);
+        acr_runtime_propose_function(init_data,
+            functions->function_priority[most_recent_function]->tcc_function,
+            functions->function_priority[most_recent_function]->
+            computed_tiles);
         atomic_store_explicit(&init_data->current_monitoring_data,
           functions->function_priority[most_recent_function]->monitor_result,
           memory_order_relaxed);
         *function_proposed_to_kernel = most_recent_function;
         *function_used_by_kernel_type = acr_kernel_function_proposed_tcc;
+        acr_function_pool_touch(&functions->pool, most_recent_function);
       } else {
         if (*function_used_by_kernel_type == acr_kernel_function_proposed_tcc) {
           void *function_pointer = atomic_load_explicit(
@@ -299,6 +649,21 @@ static void acr_valid_function_switch_to(enum acr_avaliable_function_type type,
             /*fprintf(stderr, "Kernel use tcc %zu\n", most_recent_function);*/
             *function_used_by_kernel = *function_proposed_to_kernel;
             *function_used_by_kernel_type = acr_kernel_function_using_tcc;
+            functions->function_priority[*function_used_by_kernel]->
+              adopted_at_call = init_data->kernel_info->num_calls;
+          }
+        } else if (*function_used_by_kernel_type ==
+            acr_kernel_function_using_tcc) {
+          struct func_value *const slot =
+            functions->function_priority[most_recent_function];
+          if (type == acr_function_tcc_only &&
+              *function_used_by_kernel == most_recent_function &&
+              acr_tcc_version_worth_promotion(slot, init_data,
+                compile_threads_data)) {
+            acr_compile_queue_slot(acr_function_proposed_promotion, slot,
+                compile_threads_data);
+          } else {
+            acr_coordinator_sleep(init_data);
           }
         }
       }
@@ -312,10 +677,13 @@ static void acr_valid_function_switch_to(enum acr_avaliable_function_type type,
 #endif
         if (*function_used_by_kernel_type != acr_kernel_function_using_cc) {
 
-          void *function_pointer = atomic_exchange_explicit(
-              &init_data->alternative_function,
-              functions->function_priority[most_recent_function]->cc_function,
+          // The kernel times the new version until it is evaluated
+          atomic_store_explicit(&init_data->time_kernel_calls, true,
               memory_order_relaxed);
+          void *function_pointer = acr_runtime_propose_function(init_data,
+              functions->function_priority[most_recent_function]->cc_function,
+              functions->function_priority[most_recent_function]->
+              computed_tiles);
           atomic_store_explicit(&init_data->current_monitoring_data,
               functions->function_priority[most_recent_function]->monitor_result,
               memory_order_relaxed);
@@ -328,6 +696,7 @@ static void acr_valid_function_switch_to(enum acr_avaliable_function_type type,
 #endif
           *function_used_by_kernel_type = acr_kernel_function_proposed_cc;
           *function_proposed_to_kernel = most_recent_function;
+          acr_function_pool_touch(&functions->pool, most_recent_function);
           /*fprintf(stderr, "Propose cc %zu\n", most_recent_function);*/
         }
       } else {
@@ -344,6 +713,10 @@ static void acr_valid_function_switch_to(enum acr_avaliable_function_type type,
     case acr_function_started_cloog_gen: // Cloog has not finished
     case acr_function_proposed_cloog_gen:
       break;
+    case acr_function_poisoned: // No compiler could build this version
+      // The kernel keeps its current function, wait for a new monitoring
+      acr_coordinator_sleep(init_data);
+      break;
     case acr_function_empty:
       fprintf(stderr, "Empty function in test\n");
       exit(1);
@@ -368,6 +741,42 @@ static void acr_get_most_recent_monitor_result(
   }
 }
 
+// Sleep until the monitor thread gives a result, false if the runtime stops
+static bool acr_wait_monitor_result(
+    unsigned char **const restrict valid_monitor_result,
+    unsigned char **const restrict invalid_monitor_result,
+    struct acr_runtime_data *const init_data,
+    struct acr_monitoring_computation *const monitor_data) {
+  for (;;) {
+    const size_t wakeups = acr_runtime_coordinator_wakeups(init_data);
+    acr_get_most_recent_monitor_result(valid_monitor_result,
+        invalid_monitor_result,
+        monitor_data);
+    if (*valid_monitor_result != NULL)
+      return true;
+    if (!atomic_flag_test_and_set_explicit(
+          &init_data->monitor_thread_continue, memory_order_relaxed))
+      return false;
+    acr_runtime_wait_coordinator_wakeup(init_data, wakeups);
+  }
+}
+
+// Sleep until a slot reaches one of the two given states
+static enum acr_avaliable_function_type acr_wait_function_type(
+    struct func_value *const slot,
+    enum acr_avaliable_function_type first,
+    enum acr_avaliable_function_type second,
+    struct acr_runtime_data *const init_data) {
+  for (;;) {
+    const size_t wakeups = acr_runtime_coordinator_wakeups(init_data);
+    const enum acr_avaliable_function_type type =
+      atomic_load_explicit(&slot->type, memory_order_acquire);
+    if (type == first || type == second)
+      return type;
+    acr_runtime_wait_coordinator_wakeup(init_data, wakeups);
+  }
+}
+
 static void acr_cloog_compilation(
     unsigned char ** restrict valid_monitor_result,
     unsigned char ** restrict invalid_monitor_result,
@@ -375,33 +784,33 @@ static void acr_cloog_compilation(
     struct acr_avaliable_functions *const functions,
     struct acr_runtime_threads_cloog_gencode *const cloog_thread_data) {
 
-  while(cloog_thread_data->num_threads == cloog_thread_data->num_threads_compiling) {
-    pthread_cond_wait(&cloog_thread_data->coordinator_sleep, &cloog_thread_data->mutex);
-  }
-  cloog_thread_data->where_to_add =
+  struct func_value *const where_to_add =
     functions->function_priority[most_recent_function];
-  *invalid_monitor_result = cloog_thread_data->where_to_add->monitor_result;
-  cloog_thread_data->where_to_add->monitor_result = *valid_monitor_result;
-  cloog_thread_data->generate_function = true;
-  atomic_store_explicit(
-      &functions->function_priority[most_recent_function]->type,
-      acr_function_proposed_cloog_gen,
-      memory_order_relaxed);
-  pthread_mutex_unlock(&cloog_thread_data->mutex);
+  *invalid_monitor_result = where_to_add->monitor_result;
+  where_to_add->monitor_result = *valid_monitor_result;
+  where_to_add->slower_than_original = false;
+  atomic_store(&where_to_add->type, acr_function_proposed_cloog_gen);
   *valid_monitor_result = NULL;
 
-  // CLooG it's your time to shine
-  pthread_cond_signal(&cloog_thread_data->compiler_thread_sleep);
+  // CLooG it's your time to shine. A slot already in the queue is generated
+  // with its new monitoring result when a CLooG thread takes it.
+  if (!atomic_exchange(&where_to_add->in_cloog_queue, true))
+    acr_queue_push_slot(&cloog_thread_data->jobs, where_to_add);
+}
+
+// Take back a slot no CLooG thread started to work on, its monitoring result
+// can be replaced by a more recent one
+static inline bool acr_cloog_withdraw(struct func_value *slot) {
+  enum acr_avaliable_function_type expected = acr_function_proposed_cloog_gen;
+  return atomic_compare_exchange_strong(&slot->type, &expected,
+      acr_function_empty);
 }
 
 static inline void discard_kernel_function(
     struct acr_runtime_data *const init_data,
     enum acr_kernel_function_type *function_used_by_kernel_type) {
 
-  atomic_store_explicit(
-      &init_data->alternative_function,
-      init_data->original_function,
-      memory_order_relaxed);
+  acr_runtime_propose_function(init_data, init_data->original_function, NULL);
   atomic_store_explicit(
       &init_data->current_monitoring_data,
       NULL,
@@ -409,44 +818,84 @@ static inline void discard_kernel_function(
   *function_used_by_kernel_type = acr_kernel_function_initial;
 }
 
-static inline size_t acr_next_free_function_position(
-    size_t most_recent_function,
-    size_t function_used_by_kernel,
-    size_t function_proposed_to_kernel,
-    struct acr_avaliable_functions *const functions) {
-
-  size_t next_good = most_recent_function;
-  bool good_function = false;
-  while (!good_function) {
-    next_good = (next_good+1) == functions->total_functions ? 0 : next_good+1;
-    enum acr_avaliable_function_type funtype =
-      atomic_load_explicit(
-        &functions->function_priority[next_good]->type,
+// A generated version is assumed faster than the original kernel. Once the
+// kernel ran it for a few calls, the measured times tell if it really is and
+// the kernel stops timing its calls.
+static void acr_keep_faster_function(
+    struct func_value *slot,
+    struct acr_runtime_data *const init_data,
+    enum acr_kernel_function_type *function_used_by_kernel_type) {
+  const double original_time = atomic_load_explicit(
+      &init_data->original_function_time, memory_order_relaxed);
+  const bool evaluated = original_time > 0. &&
+    atomic_load_explicit(&init_data->timed_function, memory_order_acquire) ==
+    slot->cc_function &&
+    atomic_load_explicit(&init_data->timed_function_calls,
+        memory_order_acquire) > acr_timing_min_calls;
+  if (evaluated) {
+    atomic_store_explicit(&init_data->time_kernel_calls, false,
         memory_order_relaxed);
-    switch (funtype) {
-      case acr_function_empty:
-      case acr_function_finished_cloog_gen:
+  }
+  if (evaluated && atomic_load_explicit(&init_data->timed_function_time,
+        memory_order_relaxed) > original_time * (1. + acr_timing_tolerance)) {
+    /*fprintf(stderr, "Version slower than the original kernel\n");*/
+    slot->slower_than_original = true;
+    discard_kernel_function(init_data, function_used_by_kernel_type);
+  } else {
+    acr_coordinator_sleep(init_data);
+  }
+}
+
+static bool acr_function_pool_slot_reusable(size_t slot, void *user_data) {
+  struct acr_avaliable_functions *const functions = user_data;
+  enum acr_avaliable_function_type funtype =
+    atomic_load_explicit(
+      &functions->function_priority[slot]->type,
+      memory_order_relaxed);
+  switch (funtype) {
+    case acr_function_empty:
+    case acr_function_finished_cloog_gen:
+    case acr_function_poisoned:
 #ifdef TCC_PRESENT
-      case acr_function_tcc_and_shared:
+    case acr_function_tcc_only:
+    case acr_function_tcc_and_shared:
 #else
-      case acr_function_shared_object_lib:
+    case acr_function_shared_object_lib:
 #endif
-        good_function = next_good != function_used_by_kernel &&
-          next_good != function_proposed_to_kernel;
-        break;
-      default:
-        break;
-    }
+      return true;
+    default:
+      return false;
   }
-  most_recent_function =
-    (most_recent_function+1) == functions->total_functions ? 0 : most_recent_function+1;
-  if (most_recent_function != next_good) {
-    struct func_value *const temp = functions->function_priority[next_good];
-    functions->function_priority[next_good] =
-      functions->function_priority[most_recent_function];
-    functions->function_priority[most_recent_function] = temp;
+}
+
+// The slots never move in the pool, the indices of the slots used by or
+// proposed to the kernel stay valid across calls.
+static inline size_t acr_next_free_function_position(
+    size_t function_used_by_kernel,
+    size_t function_proposed_to_kernel,
+    struct acr_avaliable_functions *const functions,
+    struct acr_runtime_data *const init_data) {
+
+  struct acr_function_pool *const pool = &functions->pool;
+  size_t next_good = pool->num_slots;
+  while (next_good == pool->num_slots) {
+    const size_t wakeups = acr_runtime_coordinator_wakeups(init_data);
+    next_good = acr_function_pool_choose_slot(pool,
+        function_used_by_kernel, function_proposed_to_kernel,
+        acr_function_pool_slot_reusable, functions);
+    // Every slot is busy, grow the pool if allowed or sleep until a code
+    // generation or a compilation releases one
+    if (next_good == pool->num_slots) {
+      const size_t new_slot = pool->num_slots;
+      if (acr_function_pool_grow(pool)) {
+        functions->function_priority[new_slot] =
+          acr_function_pool_new_slot(functions->monitor_total_size);
+      } else {
+        acr_runtime_wait_coordinator_wakeup(init_data, wakeups);
+      }
+    }
   }
-  return most_recent_function;
+  return next_good;
 }
 
 static void acr_kernel_stencil(
@@ -463,23 +912,19 @@ static void acr_kernel_stencil(
     malloc(init_data->monitor_total_size * sizeof(*monitor_data->shared_buffer->scrap_values));
   size_t most_recent_function = 0;
   size_t function_proposed_to_kernel = 0;
-  size_t function_used_by_kernel = functions->total_functions - 1;
+  size_t function_used_by_kernel = functions->pool.num_slots - 1;
   enum acr_kernel_function_type function_used_by_kernel_type =
     acr_kernel_function_initial;
 
-  for (size_t i = 0; i < functions->total_functions; ++i) {
-    functions->value[i].monitor_untouched =
-      malloc(init_data->monitor_total_size *
-          sizeof(*functions->value[i].monitor_untouched));
+  if (!acr_wait_monitor_result(&valid_monitor_result,
+                               &invalid_monitor_result,
+                               init_data,
+                               monitor_data)) {
+    free(invalid_monitor_result);
+    free(maximized_version);
+    return;
   }
 
-  do {
-    acr_get_most_recent_monitor_result(&valid_monitor_result,
-                                      &invalid_monitor_result,
-                                      monitor_data);
-  } while (valid_monitor_result == NULL);
-
-  pthread_mutex_lock(&cloog_thread_data->mutex);
   acr_cloog_compilation(&valid_monitor_result,
                         &invalid_monitor_result,
                         most_recent_function,
@@ -492,7 +937,6 @@ static void acr_kernel_stencil(
   enum acr_avaliable_function_type most_recent_function_type;
 
   bool monitor_still_valid = false, validity;
-  pthread_mutex_t sleep_mutex = PTHREAD_MUTEX_INITIALIZER;
   while (atomic_flag_test_and_set_explicit(
         &init_data->monitor_thread_continue, memory_order_relaxed)) {
     bool required_compilation;
@@ -532,9 +976,9 @@ static void acr_kernel_stencil(
             functions,
             compile_threads_data);
       } else {
-        pthread_mutex_lock(&sleep_mutex);
-        pthread_cond_wait(&init_data->coordinator_continue_cond, &sleep_mutex);
-        pthread_mutex_unlock(&sleep_mutex);
+        acr_keep_faster_function(
+            functions->function_priority[most_recent_function], init_data,
+            &function_used_by_kernel_type);
       }
 
       if (!monitor_still_valid && required_compilation) {
@@ -556,20 +1000,15 @@ static void acr_kernel_stencil(
 recompilation:
       most_recent_function_type = acr_function_empty;
 
-      pthread_mutex_lock(&cloog_thread_data->mutex);
-      bool cloog_has_to_generate = cloog_thread_data->generate_function;
-      if (!(cloog_has_to_generate &&
-          cloog_thread_data->where_to_add ==
-          functions->function_priority[most_recent_function])) {
-        if (cloog_has_to_generate)
-          pthread_mutex_unlock(&cloog_thread_data->mutex);
+      // A version still waiting for a CLooG thread is generated with the new
+      // monitoring result instead
+      if (!acr_cloog_withdraw(
+            functions->function_priority[most_recent_function])) {
         most_recent_function = acr_next_free_function_position(
-            most_recent_function,
             function_used_by_kernel,
             function_proposed_to_kernel,
-            functions);
-        if (cloog_has_to_generate)
-          pthread_mutex_lock(&cloog_thread_data->mutex);
+            functions,
+            init_data);
       }
 
       invalid_monitor_result =
@@ -586,9 +1025,6 @@ recompilation:
     }
   }
 
-  for (size_t i = 0; i < functions->total_functions; ++i) {
-    free(functions->value[i].monitor_untouched);
-  }
   free(valid_monitor_result);
   free(invalid_monitor_result);
   free(maximized_version);
@@ -611,17 +1047,19 @@ static void acr_kernel_versioning(
     malloc(init_data->monitor_total_size * sizeof(*monitor_data->shared_buffer->scrap_values));
   size_t most_recent_function = 0;
   size_t function_proposed_to_kernel = 0;
-  size_t function_used_by_kernel = functions->total_functions - 1;
+  size_t function_used_by_kernel = functions->pool.num_slots - 1;
   enum acr_kernel_function_type function_used_by_kernel_type =
     acr_kernel_function_initial;
 
-  do {
-    acr_get_most_recent_monitor_result(&valid_monitor_result,
-                                      &invalid_monitor_result,
-                                      monitor_data);
-  } while (valid_monitor_result == NULL);
+  if (!acr_wait_monitor_result(&valid_monitor_result,
+                               &invalid_monitor_result,
+                               init_data,
+                               monitor_data)) {
+    free(invalid_monitor_result);
+    free(maximized_version);
+    return;
+  }
 
-  pthread_mutex_lock(&cloog_thread_data->mutex);
   acr_cloog_compilation(&valid_monitor_result,
                         &invalid_monitor_result,
                         most_recent_function,
@@ -633,7 +1071,6 @@ static void acr_kernel_versioning(
 
   enum acr_avaliable_function_type most_recent_function_type;
   bool is_monitor_still_accurate, validity;
-  pthread_mutex_t sleep_mutex = PTHREAD_MUTEX_INITIALIZER;
   while (atomic_flag_test_and_set_explicit(
         &init_data->monitor_thread_continue, memory_order_relaxed)) {
 
@@ -670,9 +1107,9 @@ static void acr_kernel_versioning(
             functions,
             compile_threads_data);
       } else {
-        pthread_mutex_lock(&sleep_mutex);
-        pthread_cond_wait(&init_data->coordinator_continue_cond, &sleep_mutex);
-        pthread_mutex_unlock(&sleep_mutex);
+        acr_keep_faster_function(
+            functions->function_priority[most_recent_function], init_data,
+            &function_used_by_kernel_type);
       }
 
       invalid_monitor_result = valid_monitor_result;
@@ -701,20 +1138,15 @@ static void acr_kernel_versioning(
         /*fprintf(stderr, "Changing version no more suitable %f\n", delta);*/
       }
 
-      pthread_mutex_lock(&cloog_thread_data->mutex);
-      bool cloog_has_to_generate = cloog_thread_data->generate_function;
-      if (!(cloog_has_to_generate &&
-          cloog_thread_data->where_to_add ==
-          functions->function_priority[most_recent_function])) {
-        if (cloog_has_to_generate)
-          pthread_mutex_unlock(&cloog_thread_data->mutex);
+      // A version still waiting for a CLooG thread is generated with the new
+      // monitoring result instead
+      if (!acr_cloog_withdraw(
+            functions->function_priority[most_recent_function])) {
         most_recent_function = acr_next_free_function_position(
-            most_recent_function,
             function_used_by_kernel,
             function_proposed_to_kernel,
-            functions);
-        if (cloog_has_to_generate)
-          pthread_mutex_lock(&cloog_thread_data->mutex);
+            functions,
+            init_data);
       }
 
       acr_cloog_compilation(&valid_monitor_result,
@@ -759,6 +1191,25 @@ static void print_pool_caller_function(const char *prefix, FILE *out) {
       prefix);
 }
 
+// In optimal generation mode the kernel waits for a function after every
+// call. A slot without a usable version gives it the TCC version or the
+// original kernel.
+static void acr_propose_optimum_kernel_function(
+    const struct func_value *slot,
+    struct acr_runtime_data *const init_data) {
+  void *function = init_data->original_function;
+  if (!slot->slower_than_original) {
+    if (slot->cc_function)
+      function = slot->cc_function;
+#ifdef TCC_PRESENT
+    else if (slot->tcc_function)
+      function = slot->tcc_function;
+#endif
+  }
+  acr_runtime_propose_function(init_data, function,
+      function == init_data->original_function ? NULL : slot->computed_tiles);
+}
+
 static void acr_kernel_sequential_optimum_gencode(
     struct acr_runtime_data *const init_data,
     struct acr_avaliable_functions *const functions,
@@ -800,17 +1251,14 @@ static void acr_kernel_sequential_optimum_gencode(
       break;
   }
 
-  do {
-    if (!atomic_flag_test_and_set_explicit(
-          &init_data->monitor_thread_continue, memory_order_relaxed))
-      goto end_generate_kernel;
-    acr_get_most_recent_monitor_result(&valid_monitor_result,
+  if (!acr_wait_monitor_result(&valid_monitor_result,
         &invalid_monitor_result,
-        monitor_data);
-  } while (valid_monitor_result == NULL);
+        init_data,
+        monitor_data))
+    goto end_generate_kernel;
 
   size_t most_recent_function = 0;
-  size_t function_used_by_kernel = functions->total_functions - 1;
+  size_t function_used_by_kernel = functions->pool.num_slots - 1;
   size_t function_num = 1, current_function_num = 1;
   goto starting_generation;
 
@@ -822,14 +1270,11 @@ static void acr_kernel_sequential_optimum_gencode(
           /*memory_order_relaxed);*/
     /*} while (function_pointer != NULL);*/
 
-    do {
-      if (!atomic_flag_test_and_set_explicit(
-        &init_data->monitor_thread_continue, memory_order_relaxed))
-        goto end_generate_kernel;
-      acr_get_most_recent_monitor_result(&valid_monitor_result,
+    if (!acr_wait_monitor_result(&valid_monitor_result,
           &invalid_monitor_result,
-          monitor_data);
-    } while (valid_monitor_result == NULL);
+          init_data,
+          monitor_data))
+      goto end_generate_kernel;
 
     bool validity = false;
     bool required_compilation = false;
@@ -868,32 +1313,29 @@ static void acr_kernel_sequential_optimum_gencode(
     if (validity && !required_compilation) { // Current function is still valid
       write_function_to_caller(function_num, current_function_num,
           function_call_function, functions->function_priority[most_recent_function]->generated_code);
-      atomic_store_explicit(&init_data->alternative_function,
-          functions->function_priority[most_recent_function]->tcc_function,
-          memory_order_relaxed);
+      acr_propose_optimum_kernel_function(
+          functions->function_priority[most_recent_function], init_data);
       invalid_monitor_result = valid_monitor_result;
       valid_monitor_result = NULL;
     } else { // The function is no more valid -> compilation
 starting_generation:
       function_used_by_kernel_type = acr_kernel_function_initial;
-      pthread_mutex_lock(&cloog_thread_data->mutex);
       most_recent_function = acr_next_free_function_position(
-          most_recent_function,
           function_used_by_kernel,
           function_used_by_kernel,
-          functions);
+          functions,
+          init_data);
       acr_cloog_compilation(&valid_monitor_result,
           &invalid_monitor_result,
           most_recent_function,
           functions,
           cloog_thread_data);
-      enum acr_avaliable_function_type most_recent_function_type;
-      do {
-        most_recent_function_type =
-          atomic_load_explicit(
-              &functions->function_priority[most_recent_function]->type,
-              memory_order_acquire);
-      } while (most_recent_function_type != acr_function_finished_cloog_gen);
+      enum acr_avaliable_function_type most_recent_function_type =
+        acr_wait_function_type(
+            functions->function_priority[most_recent_function],
+            acr_function_finished_cloog_gen,
+            acr_function_finished_cloog_gen,
+            init_data);
 
       current_function_num += 1;
       write_new_function_to_pool(function_num, current_function_num,
@@ -909,25 +1351,34 @@ starting_generation:
           init_data,
           functions,
           compile_threads_data);
-      do {
-        most_recent_function_type =
-          atomic_load_explicit(
-              &functions->function_priority[most_recent_function]->type,
-              memory_order_acquire);
+      most_recent_function_type =
+        acr_wait_function_type(
+            functions->function_priority[most_recent_function],
 #ifdef TCC_PRESENT
-      } while (most_recent_function_type != acr_function_tcc_and_shared);
+            acr_function_tcc_and_shared,
 #else
-      } while (most_recent_function_type != acr_function_shared_object_lib);
+            acr_function_shared_object_lib,
 #endif
-      acr_valid_function_switch_to(most_recent_function_type,
-          &function_used_by_kernel_type,
-          &function_used_by_kernel,
-          &no_care,
-          most_recent_function,
-          init_data,
-          functions,
-          compile_threads_data);
+            acr_function_poisoned,
+            init_data);
+      if (most_recent_function_type != acr_function_poisoned)
+        acr_valid_function_switch_to(most_recent_function_type,
+            &function_used_by_kernel_type,
+            &function_used_by_kernel,
+            &no_care,
+            most_recent_function,
+            init_data,
+            functions,
+            compile_threads_data);
+      // Nothing was proposed if the compilation failed, the kernel would
+      // wait forever
+      if (atomic_load_explicit(&init_data->alternative_function,
+            memory_order_relaxed) == NULL) {
+        acr_propose_optimum_kernel_function(
+            functions->function_priority[most_recent_function], init_data);
+      }
     }
+    acr_runtime_wake_kernel(init_data);
     function_num += 1;
 
   } while (atomic_flag_test_and_set_explicit(
@@ -965,24 +1416,24 @@ static void acr_kernel_simple(
   unsigned char *invalid_monitor_result =
     malloc(init_data->monitor_total_size * sizeof(*monitor_data->shared_buffer->scrap_values));
   size_t most_recent_function = 0;
-  size_t function_used_by_kernel = functions->total_functions - 1;
+  size_t function_used_by_kernel = functions->pool.num_slots - 1;
   enum acr_kernel_function_type function_used_by_kernel_type =
     acr_kernel_function_initial;
 
-  do {
-    acr_get_most_recent_monitor_result(&valid_monitor_result,
-                                      &invalid_monitor_result,
-                                      monitor_data);
-  } while (valid_monitor_result == NULL);
+  if (!acr_wait_monitor_result(&valid_monitor_result,
+                               &invalid_monitor_result,
+                               init_data,
+                               monitor_data)) {
+    free(invalid_monitor_result);
+    return;
+  }
 
-  pthread_mutex_lock(&cloog_thread_data->mutex);
   acr_cloog_compilation(&valid_monitor_result,
                               &invalid_monitor_result,
                               most_recent_function,
                               functions,
                               cloog_thread_data);
 
-  pthread_mutex_t sleep_mutex = PTHREAD_MUTEX_INITIALIZER;
   bool is_monitor_still_accurate, validity;
   while (atomic_flag_test_and_set_explicit(
         &init_data->monitor_thread_continue, memory_order_relaxed)) {
@@ -1020,9 +1471,9 @@ static void acr_kernel_simple(
           functions,
           compile_threads_data);
       } else {
-        pthread_mutex_lock(&sleep_mutex);
-        pthread_cond_wait(&init_data->coordinator_continue_cond, &sleep_mutex);
-        pthread_mutex_unlock(&sleep_mutex);
+        acr_keep_faster_function(
+            functions->function_priority[most_recent_function], init_data,
+            &function_used_by_kernel_type);
       }
 
       invalid_monitor_result = valid_monitor_result;
@@ -1036,43 +1487,15 @@ static void acr_kernel_simple(
 
       discard_kernel_function(init_data, &function_used_by_kernel_type);
 
-      bool cloog_was_ready = true;
-      pthread_mutex_lock(&cloog_thread_data->mutex);
-      if(cloog_thread_data->num_threads ==
-          cloog_thread_data->num_threads_compiling) { // All CLooGs are busy
-        cloog_was_ready = false;
-      }
-      bool cloog_has_to_generate = cloog_thread_data->generate_function;
-      if (!(cloog_has_to_generate &&
-          cloog_thread_data->where_to_add ==
-          functions->function_priority[most_recent_function])) {
-        if (cloog_has_to_generate)
-          pthread_mutex_unlock(&cloog_thread_data->mutex);
+      // A version still waiting for a CLooG thread is generated with the new
+      // monitoring result instead
+      if (!acr_cloog_withdraw(
+            functions->function_priority[most_recent_function])) {
         most_recent_function = acr_next_free_function_position(
-            most_recent_function,
             function_used_by_kernel,
             function_used_by_kernel,
-            functions);
-        if (cloog_has_to_generate)
-          pthread_mutex_lock(&cloog_thread_data->mutex);
-      }
-
-      while(!cloog_was_ready && cloog_thread_data->num_threads ==
-          cloog_thread_data->num_threads_compiling) { // All CLooGs are busy
-        pthread_cond_wait(&cloog_thread_data->coordinator_sleep,
-            &cloog_thread_data->mutex);
-      }
-
-      if (!cloog_was_ready) { // if cloog was not finished so get most recent again
-        invalid_monitor_result = valid_monitor_result;
-        valid_monitor_result = NULL;
-        acr_get_most_recent_monitor_result(&valid_monitor_result,
-            &invalid_monitor_result,
-            monitor_data);
-        if (valid_monitor_result == NULL) {
-          valid_monitor_result = invalid_monitor_result;
-          invalid_monitor_result = NULL;
-        }
+            functions,
+            init_data);
       }
 
       acr_cloog_compilation(&valid_monitor_result,
@@ -1089,31 +1512,39 @@ static void acr_kernel_simple(
 void* acr_verification_and_coordinator_function(void *in_data) {
   struct acr_runtime_data *const init_data =
     (struct acr_runtime_data*) in_data;
+  acr_runtime_place_thread(acr_thread_coordinator);
 
   const size_t monitor_total_size = init_data->monitor_total_size;
 
-  const size_t num_functions = 10;
   struct acr_avaliable_functions functions = {
-    .total_functions = num_functions,
+    .monitor_total_size = monitor_total_size,
   };
-  functions.value = malloc(functions.total_functions * sizeof(*functions.value));
-  functions.function_priority = malloc(functions.total_functions *
+  acr_function_pool_init(&functions.pool, init_data->function_pool_size,
+      init_data->function_pool_max_size);
+  // The array is allocated once for its maximal size, so that growing the
+  // pool never moves the slots used by the other threads.
+  functions.function_priority = malloc(functions.pool.max_slots *
       sizeof(*functions.function_priority));
-  for (size_t i = 0; i < functions.total_functions; ++i) {
-#ifdef TCC_PRESENT
-    functions.value[i].compiler_specific.tcc.state = NULL;
-#endif
-    functions.value[i].compiler_specific.shared_obj_lib.dlhandle = NULL;
-    atomic_store(&functions.value[i].type, acr_function_empty);
-    functions.value[i].monitor_result =
-      malloc(monitor_total_size *
-          sizeof(*functions.value[i].monitor_result));
-    functions.function_priority[i] = &functions.value[i];
-    functions.value[i].memstream =
-      open_memstream(&functions.value[i].generated_code,
-          &functions.value[i].sizeof_string);
+  for (size_t i = 0; i < functions.pool.num_slots; ++i) {
+    functions.function_priority[i] =
+      acr_function_pool_new_slot(monitor_total_size);
   }
 
+  // Every pool slot holds at most one entry, keep some room for old versions.
+  // The versions are told apart by the alternatives of the tiles.
+  unsigned char value_keys[UCHAR_MAX + 1];
+  for (size_t value = 0; value <= UCHAR_MAX; ++value) {
+    const struct runtime_alternative *alternative =
+      init_data->alternative_from_val((unsigned char) value);
+    value_keys[value] = alternative ?
+      (unsigned char) alternative->alternative_number :
+      ACR_VERSION_CACHE_NO_ALTERNATIVE;
+  }
+  struct acr_version_cache version_cache;
+  acr_version_cache_init(&version_cache,
+      functions.pool.max_slots + acr_version_cache_history,
+      monitor_total_size, value_keys);
+
   // Monitoring thread
   pthread_t monitoring_thread;
   struct acr_monitoring_shared shared_monitor_data = {
@@ -1125,15 +1556,20 @@ void* acr_verification_and_coordinator_function(void *in_data) {
     .monitoring_function = init_data->monitoring_function,
     .shared_buffer = &shared_monitor_data,
     .monitor_result_size = monitor_total_size,
-    .end_yourself = ATOMIC_FLAG_INIT,
+    .num_threads = init_data->num_monitor_threads,
+    .num_outer_tiles = (long) init_data->monitor_dim_max[0],
+    .dirty_tracking = &init_data->dirty_tracking,
+    .dirty_outer_tiles = init_data->dirty_outer_tiles,
+    .end_yourself = false,
     .sleep_cond = &init_data->monitor_sleep_cond,
-    .coordinator_continue_cond = &init_data->coordinator_continue_cond,
+    .sleep_mutex = &init_data->monitor_sleep_mutex,
+    .sleeping = &init_data->monitor_sleeping,
+    .coordinator = init_data,
 #ifdef ACR_STATS_ENABLED
     .num_mesurement = 0,
     .total_time = 0.,
 #endif
   };
-  atomic_flag_test_and_set(&monitor_data.end_yourself);
   monitor_data.shared_buffer->scrap_values =
     malloc(monitor_total_size * sizeof(*monitor_data.shared_buffer->scrap_values));
   pthread_create(&monitoring_thread, NULL, acr_runtime_monitoring_function,
@@ -1143,26 +1579,33 @@ void* acr_verification_and_coordinator_function(void *in_data) {
   const size_t num_compilation_threads = init_data->num_compile_threads;
   struct acr_runtime_threads_compile_data compile_threads_data = {
     .num_cflags = init_data->num_compiler_flags,
-    .end_yourself = false,
-    .compile_something = false,
+    .cflags = init_data->compiler_flags,
+    .cache_dir = init_data->compile_cache_dir,
+    .version_cache = &version_cache,
+    .compile_servers = init_data->compile_servers,
+    .next_thread_num = 0,
+    .eager_cc = init_data->generate_optimum_function ||
+      init_data->promotion_calls == 0,
+    .cc_time_estimate = 0.,
     .num_threads = num_compilation_threads,
-    .num_threads_compiling = num_compilation_threads,
-    .coordinator_continue_cond = &init_data->coordinator_continue_cond,
+    .coordinator = init_data,
 #ifdef ACR_STATS_ENABLED
     .num_mesurement = 0,
     .total_time = 0.,
     .num_tcc_mesurement = 0,
     .total_tcc_time = 0.,
+    .num_cc_failures = 0,
+    .num_tcc_failures = 0,
+    .num_degraded_versions = 0,
+    .num_poisoned_versions = 0,
 #endif
   };
 
   pthread_t *compile_threads =
     malloc(num_compilation_threads * sizeof(*compile_threads));
+  acr_queue_init(&compile_threads_data.pending, functions.pool.max_slots);
   pthread_mutex_init(&compile_threads_data.mutex, NULL);
-  pthread_cond_init(&compile_threads_data.compiler_thread_sleep, NULL);
-  pthread_cond_init(&compile_threads_data.coordinator_sleep, NULL);
   for (size_t i = 0; i < num_compilation_threads; ++i) {
-    compile_threads_data.cflags = init_data->compiler_flags[i];
     pthread_create(&compile_threads[i], NULL,
         acr_runtime_compile_thread, (void*)&compile_threads_data);
   }
@@ -1173,20 +1616,17 @@ void* acr_verification_and_coordinator_function(void *in_data) {
     malloc(num_cloog_threads * sizeof(*compile_threads));
   struct acr_runtime_threads_cloog_gencode cloog_thread_data = {
     .thread_num = 0,
-    .end_yourself = false,
-    .generate_function = false,
     .num_threads = num_cloog_threads,
-    .num_threads_compiling = num_cloog_threads,
-    .coordinator_continue_cond = &init_data->coordinator_continue_cond,
     .rdata = init_data,
+    .version_cache = &version_cache,
 #ifdef ACR_STATS_ENABLED
     .num_mesurement = 0,
     .total_time = 0.,
 #endif
   };
+  // A slot is in the queue at most once, the queue can hold the whole pool
+  acr_queue_init(&cloog_thread_data.jobs, functions.pool.max_slots);
   pthread_mutex_init(&cloog_thread_data.mutex, NULL);
-  pthread_cond_init(&cloog_thread_data.coordinator_sleep, NULL);
-  pthread_cond_init(&cloog_thread_data.compiler_thread_sleep, NULL);
   for (size_t i = 0; i < num_cloog_threads; ++i) {
     pthread_create(&cloog_threads[i], NULL, acr_cloog_generate_code_from_alt,
         (void*)&cloog_thread_data);
@@ -1218,48 +1658,34 @@ void* acr_verification_and_coordinator_function(void *in_data) {
     }
 
   // Quit compile threads
-  pthread_mutex_lock(&compile_threads_data.mutex);
-  compile_threads_data.end_yourself = true;
-  pthread_mutex_unlock(&compile_threads_data.mutex);
-  pthread_cond_broadcast(&compile_threads_data.compiler_thread_sleep);
+  acr_queue_close(&compile_threads_data.pending);
   for (size_t i = 0; i < num_compilation_threads; ++i) {
     pthread_join(compile_threads[i], NULL);
   }
   pthread_mutex_destroy(&compile_threads_data.mutex);
-  pthread_cond_destroy(&compile_threads_data.compiler_thread_sleep);
-  pthread_cond_destroy(&compile_threads_data.coordinator_sleep);
+  acr_queue_free(&compile_threads_data.pending);
   free(compile_threads);
 
   // Quit cloog threads
-  pthread_mutex_lock(&cloog_thread_data.mutex);
-  cloog_thread_data.end_yourself = true;
-  pthread_mutex_unlock(&cloog_thread_data.mutex);
-  pthread_cond_broadcast(&cloog_thread_data.compiler_thread_sleep);
+  acr_queue_close(&cloog_thread_data.jobs);
   for (size_t i = 0; i < num_cloog_threads; ++i) {
     pthread_join(cloog_threads[i], NULL);
   }
   pthread_mutex_destroy(&cloog_thread_data.mutex);
-  pthread_cond_destroy(&cloog_thread_data.compiler_thread_sleep);
-  pthread_cond_destroy(&cloog_thread_data.coordinator_sleep);
+  acr_queue_free(&cloog_thread_data.jobs);
 
   // Quit monitoring thread
-  atomic_flag_clear(&monitor_data.end_yourself);
+  atomic_store(&monitor_data.end_yourself, true);
+  pthread_mutex_lock(&init_data->monitor_sleep_mutex);
   pthread_cond_signal(&init_data->monitor_sleep_cond);
+  pthread_mutex_unlock(&init_data->monitor_sleep_mutex);
   pthread_join(monitoring_thread, NULL);
   free(cloog_threads);
 
   // Clean all
-  for (size_t i = 0; i < functions.total_functions; ++i) {
-    fclose(functions.value[i].memstream);
-    free(functions.value[i].generated_code);
-    free(functions.value[i].monitor_result);
-    if (functions.value[i].compiler_specific.shared_obj_lib.dlhandle)
-        dlclose(functions.value[i].
-            compiler_specific.shared_obj_lib.dlhandle);
-#ifdef TCC_PRESENT
-    if (functions.value[i].compiler_specific.tcc.state)
-        tcc_delete(functions.value[i].compiler_specific.tcc.state);
-#endif
+  for (size_t i = 0; i < functions.pool.num_slots; ++i) {
+    acr_function_pool_free_slot(functions.function_priority[i],
+        &version_cache);
   }
 
 #ifdef ACR_STATS_ENABLED
@@ -1279,9 +1705,18 @@ void* acr_verification_and_coordinator_function(void *in_data) {
       compile_threads_data.num_tcc_mesurement;
     init_data->acr_stats->thread_stats.total_time[acr_thread_time_tcc] =
       compile_threads_data.total_tcc_time;
+    init_data->acr_stats->thread_stats.num_cc_failures =
+      compile_threads_data.num_cc_failures;
+    init_data->acr_stats->thread_stats.num_tcc_failures =
+      compile_threads_data.num_tcc_failures;
+    init_data->acr_stats->thread_stats.num_degraded_versions =
+      compile_threads_data.num_degraded_versions;
+    init_data->acr_stats->thread_stats.num_poisoned_versions =
+      compile_threads_data.num_poisoned_versions;
 #endif
 
-  free(functions.value);
+  acr_version_cache_free(&version_cache);
+  acr_function_pool_free(&functions.pool);
   free(functions.function_priority);
   pthread_exit(NULL);
 }
@@ -1289,6 +1724,7 @@ void* acr_verification_and_coordinator_function(void *in_data) {
 static void* acr_cloog_generate_code_from_alt(void* in_data) {
   struct acr_runtime_threads_cloog_gencode *const input_data =
     (struct acr_runtime_threads_cloog_gencode *) in_data;
+  acr_runtime_place_thread(acr_thread_cloog);
 
   pthread_mutex_lock(&input_data->mutex);
   const size_t thread_num = input_data->thread_num;
@@ -1301,33 +1737,24 @@ static void* acr_cloog_generate_code_from_alt(void* in_data) {
 #endif
 
   FILE* stream;
-  isl_set **generation_buffer =
-    malloc(input_data->rdata->num_alternatives * sizeof(*generation_buffer));
+  struct acr_cloog_generation_buffer generation_buffer;
+  acr_cloog_generation_buffer_init(&generation_buffer, input_data->rdata);
 
   for (;;) {
-    struct func_value *where_to_add;
+    void *job;
     unsigned char *monitor_result;
-    bool has_to_stop;
-
-    pthread_mutex_lock(&input_data->mutex);
 
-    if(input_data->num_threads_compiling == input_data->num_threads) {
-      pthread_cond_signal(&input_data->coordinator_sleep);
-    }
-    input_data->num_threads_compiling--;
-    while(!input_data->generate_function && !input_data->end_yourself) {
-      pthread_cond_wait(&input_data->compiler_thread_sleep, &input_data->mutex);
-    }
-    input_data->generate_function = false;
-    input_data->num_threads_compiling++;
-    has_to_stop = input_data->end_yourself;
-    where_to_add = input_data->where_to_add;
-    atomic_store(&where_to_add->type, acr_function_started_cloog_gen);
-
-    pthread_mutex_unlock(&input_data->mutex);
-
-    if (has_to_stop)
+    if (acr_queue_pop_wait(&input_data->jobs, &job, 1) == 0)
       break;
+    struct func_value *const where_to_add = job;
+    // The coordinator may have withdrawn the slot, or already given it a new
+    // monitoring result that a previous job generated
+    atomic_store(&where_to_add->in_cloog_queue, false);
+    enum acr_avaliable_function_type expected =
+      acr_function_proposed_cloog_gen;
+    if (!atomic_compare_exchange_strong(&where_to_add->type, &expected,
+          acr_function_started_cloog_gen))
+      continue;
 
     monitor_result = where_to_add->monitor_result;
     stream = where_to_add->memstream;
@@ -1336,20 +1763,32 @@ static void* acr_cloog_generate_code_from_alt(void* in_data) {
     acr_get_current_time(&tstart);
 #endif
 
-    fseek(stream, 0l, SEEK_SET);
-    fprintf(stream, "#include \"acr_required_definitions.h\"\n"
-        "void acr_alternative_function%s {\n",
-        input_data->rdata->function_prototype);
-    acr_cloog_generate_alternative_code_from_input(stream, input_data->rdata,
-        monitor_result, thread_num, generation_buffer);
-    fprintf(stream, "}\n%c", '\0');
+    acr_slot_release_version(input_data->version_cache, where_to_add);
+    where_to_add->version =
+      acr_version_cache_acquire(input_data->version_cache, monitor_result);
 
+    fseek(stream, 0l, SEEK_SET);
+    if (where_to_add->version) { // Alternatives already seen, reuse the code
+      fprintf(stream, "%s%c", where_to_add->version->generated_code, '\0');
+      fflush(stream);
+    } else {
+      fprintf(stream, "%s"
+          "void acr_alternative_function%s {\n",
+          acr_required_definitions_include,
+          input_data->rdata->function_prototype);
+      acr_cloog_generate_alternative_code_from_input(stream, input_data->rdata,
+          monitor_result, thread_num, &generation_buffer);
+      fprintf(stream, "}\n%c", '\0');
+      fflush(stream);
+      where_to_add->version = acr_version_cache_insert(
+          input_data->version_cache, monitor_result,
+          where_to_add->generated_code);
+    }
     // Now the pointers in function structure are up to date
-    fflush(stream);
 
     atomic_store_explicit(&where_to_add->type, acr_function_finished_cloog_gen,
         memory_order_release);
-    pthread_cond_signal(input_data->coordinator_continue_cond);
+    acr_runtime_wake_coordinator(input_data->rdata);
 
     /*fprintf(stderr, "%s\n", where_to_add->generated_code);*/
 
@@ -1367,7 +1806,7 @@ static void* acr_cloog_generate_code_from_alt(void* in_data) {
   input_data->num_mesurement += num_mesurement;
   pthread_mutex_unlock(&input_data->mutex);
 #endif
-  free(generation_buffer);
+  acr_cloog_generation_buffer_free(&generation_buffer, input_data->rdata);
 
   pthread_exit(NULL);
 }
@@ -1376,13 +1815,16 @@ static void* acr_cloog_generate_code_from_alt(void* in_data) {
 static void* acr_runtime_compile_tcc(void* in_data) {
   struct acr_runtime_threads_compile_tcc *const input_data =
     (struct acr_runtime_threads_compile_tcc *) in_data;
+  acr_runtime_place_thread(acr_thread_compile);
 
 #ifdef ACR_STATS_ENABLED
   double total_time = 0.;
   size_t num_mesurement = 0;
+  size_t num_failures = 0;
 #endif
 
-  struct func_value *where_to_add;
+  struct func_value **batch;
+  size_t batch_size;
 
   bool has_to_stop;
   for (;;) {
@@ -1394,50 +1836,70 @@ static void* acr_runtime_compile_tcc(void* in_data) {
       pthread_cond_wait(&input_data->waking_up, &input_data->mutex);
     }
     has_to_stop = input_data->end_yourself;
-    where_to_add = input_data->where_to_add;
+    batch = input_data->batch;
+    batch_size = input_data->batch_size;
     input_data->compile_something = true;
     pthread_mutex_unlock(&input_data->mutex);
 
     if (has_to_stop)
       break;
 
+    // TCC is fast enough to compile each slot on its own
+    for (size_t i = 0; i < batch_size; ++i) {
+      struct func_value *const where_to_add = batch[i];
 #ifdef ACR_STATS_ENABLED
-    acr_time tstart;
-    acr_get_current_time(&tstart);
+      acr_time tstart;
+      acr_get_current_time(&tstart);
 #endif
 
-    TCCState *tccstate =
-      acr_compile_with_tcc(where_to_add->generated_code);
-    void *function =
-      tcc_get_symbol(tccstate, "acr_alternative_function");
-
-    TCCState *old_tccstate = where_to_add->compiler_specific.tcc.state;
-    where_to_add->compiler_specific.tcc.state =
-      tccstate;
-    where_to_add->tcc_function = function;
-      enum acr_avaliable_function_type t = acr_function_proposed_compilation;
-      if (! atomic_compare_exchange_strong_explicit(
-          &where_to_add->type,
-          &t,
-          acr_function_tcc_in_memory,
-          memory_order_release,
-          memory_order_relaxed)) {
-        atomic_store_explicit(
+      // The state of a cached version belongs to the cache
+      TCCState *tccstate = NULL;
+      void *function = acr_version_cache_get_function(
+          input_data->version_cache, where_to_add->version,
+          acr_version_tier_quick);
+      if (function == NULL) {
+        tccstate = acr_compile_with_tcc(where_to_add->generated_code);
+        if (tccstate) {
+          function = tcc_get_symbol(tccstate, "acr_alternative_function");
+        }
+#ifdef ACR_STATS_ENABLED
+        if (function == NULL)
+          num_failures += 1;
+#endif
+        if (function && where_to_add->version) {
+          function = acr_version_cache_set_function(input_data->version_cache,
+              where_to_add->version, acr_version_tier_quick, tccstate,
+              acr_unload_tcc_state, function);
+          tccstate = NULL;
+        }
+      }
+
+      TCCState *old_tccstate = where_to_add->compiler_specific.tcc.state;
+      where_to_add->compiler_specific.tcc.state =
+        tccstate;
+      where_to_add->tcc_function = function;
+      // The compile thread publishes the final state once cc is done too
+      if (function) {
+        enum acr_avaliable_function_type t = acr_function_proposed_compilation;
+        atomic_compare_exchange_strong_explicit(
             &where_to_add->type,
-            acr_function_tcc_and_shared,
-            memory_order_release);
+            &t,
+            acr_function_tcc_in_memory,
+            memory_order_release,
+            memory_order_relaxed);
+        acr_runtime_wake_coordinator(input_data->coordinator);
       }
-      pthread_cond_signal(input_data->coordinator_continue_cond);
 
 #ifdef ACR_STATS_ENABLED
-    acr_time tend;
-    acr_get_current_time(&tend);
-    total_time += acr_difftime(tstart, tend);
-    num_mesurement += 1;
+      acr_time tend;
+      acr_get_current_time(&tend);
+      total_time += acr_difftime(tstart, tend);
+      num_mesurement += 1;
 #endif
 
-    if (old_tccstate != NULL) {
-      tcc_delete(old_tccstate);
+      if (old_tccstate != NULL) {
+        tcc_delete(old_tccstate);
+      }
     }
 
   }
@@ -1445,57 +1907,169 @@ static void* acr_runtime_compile_tcc(void* in_data) {
 #ifdef ACR_STATS_ENABLED
   input_data->total_time = total_time;
   input_data->num_mesurement = num_mesurement;
+  input_data->num_failures = num_failures;
 #endif
 
   pthread_exit(NULL);
 }
 #endif
 
+// Put the code of several slots in one translation unit. The function of the
+// slot i is renamed acr_alternative_function_i.
+static char* acr_runtime_batch_code(
+    size_t batch_size,
+    struct func_value *const *batch) {
+  const size_t include_length = strlen(acr_required_definitions_include);
+  char *code;
+  size_t code_size;
+  FILE *stream = open_memstream(&code, &code_size);
+  fprintf(stream, "%s", acr_required_definitions_include);
+  for (size_t i = 0; i < batch_size; ++i) {
+    const char *function_code = batch[i]->generated_code;
+    if (strncmp(function_code, acr_required_definitions_include,
+          include_length) == 0)
+      function_code += include_length;
+    fprintf(stream,
+        "#define acr_alternative_function acr_alternative_function_%zu\n"
+        "%s"
+        "#undef acr_alternative_function\n",
+        i, function_code);
+  }
+  fclose(stream);
+  return code;
+}
+
+// Compile the code of a batch of slots with the system compiler in one
+// shared object and load it. Each slot gets its own reference to the shared
+// object so that the version cache can close them independently.
+static bool acr_runtime_compile_and_load(
+    struct acr_runtime_threads_compile_data *const input_data,
+    struct acr_compile_server *compile_server,
+    char **cflags,
+    size_t batch_size,
+    struct func_value *const *batch) {
+  char *batch_code = NULL;
+  const char *code;
+  if (batch_size == 1) {
+    code = batch[0]->generated_code;
+  } else {
+    batch_code = acr_runtime_batch_code(batch_size, batch);
+    code = batch_code;
+  }
+  char *file;
+  bool in_cache = false;
+  if (input_data->cache_dir) {
+    file =
+      acr_compile_with_system_compiler_cached(
+          compile_server,
+          input_data->cache_dir,
+          code,
+          input_data->num_cflags,
+          cflags,
+          &in_cache);
+  } else {
+    file =
+      acr_compile_with_system_compiler(
+          compile_server,
+          NULL,
+          code,
+          input_data->num_cflags,
+          cflags);
+  }
+  free(batch_code);
+  if(!file) {
+    fprintf(stderr, "Compiler error\n");
+    return false;
+  }
+  bool loaded = true;
+  size_t num_loaded = 0;
+  char name_buffer[64];
+  for (; loaded && num_loaded < batch_size; ++num_loaded) {
+    struct func_value *const where_to_add = batch[num_loaded];
+    void *dlhandle = dlopen(file, RTLD_NOW);
+    if(!dlhandle) {
+      fprintf(stderr, "dlopen error: %s\n", dlerror());
+      loaded = false;
+      break;
+    }
+    if (batch_size == 1) {
+      snprintf(name_buffer, sizeof(name_buffer), "acr_alternative_function");
+    } else {
+      snprintf(name_buffer, sizeof(name_buffer),
+          "acr_alternative_function_%zu", num_loaded);
+    }
+    void *function = dlsym(dlhandle, name_buffer);
+    if(!function) {
+      fprintf(stderr, "dlsym error: %s\n", dlerror());
+      dlclose(dlhandle);
+      loaded = false;
+      break;
+    }
+    acr_slot_set_compiled_code(input_data->version_cache, where_to_add,
+        dlhandle, acr_unload_shared_object, function);
+  }
+  if(!in_cache && unlink(file) == -1) {
+    perror("unlink");
+  }
+  free(file);
+  // On failure, the first slots of the batch keep their function
+  return loaded;
+}
+
 static void* acr_runtime_compile_thread(void* in_data) {
   struct acr_runtime_threads_compile_data *const input_data =
     (struct acr_runtime_threads_compile_data *) in_data;
+  acr_runtime_place_thread(acr_thread_compile);
 
 #ifdef ACR_STATS_ENABLED
   double total_time = 0.;
   size_t num_mesurement = 0;
+  size_t num_cc_failures = 0;
+  size_t num_degraded_versions = 0;
+  size_t num_poisoned_versions = 0;
+#endif
+
+  void **jobs = malloc(acr_compile_max_batch * sizeof(*jobs));
+  struct func_value **batch =
+    malloc(acr_compile_max_batch * sizeof(*batch));
+  struct func_value **to_compile =
+    malloc(acr_compile_max_batch * sizeof(*to_compile));
+#ifdef TCC_PRESENT
+  struct func_value **tcc_batch =
+    malloc(acr_compile_max_batch * sizeof(*tcc_batch));
+  bool *deferred = malloc(acr_compile_max_batch * sizeof(*deferred));
 #endif
 
-  char* file;
-  struct func_value *where_to_add;
+  // The compiler options are modified by each compilation, every thread
+  // uses its own array
+  pthread_mutex_lock(&input_data->mutex);
+  const size_t thread_num = input_data->next_thread_num++;
+  pthread_mutex_unlock(&input_data->mutex);
+  char **const cflags = input_data->cflags[thread_num];
+  struct acr_compile_server *compile_server = NULL;
+  if (input_data->compile_servers)
+    compile_server = &input_data->compile_servers[thread_num];
 
 #ifdef TCC_PRESENT
   pthread_t tcc_thread;
   struct acr_runtime_threads_compile_tcc tcc_data;
   tcc_data.compile_something = true;
   tcc_data.end_yourself = false;
-  tcc_data.coordinator_continue_cond = input_data->coordinator_continue_cond;
+  tcc_data.coordinator = input_data->coordinator;
+  tcc_data.version_cache = input_data->version_cache;
   pthread_mutex_init(&tcc_data.mutex, NULL);
   pthread_cond_init(&tcc_data.waking_up, NULL);
   pthread_create(&tcc_thread, NULL, acr_runtime_compile_tcc, (void*)&tcc_data);
 #endif
 
   for (;;) {
-    bool has_to_stop;
-
-    pthread_mutex_lock(&input_data->mutex);
-
-    if(input_data->num_threads_compiling == input_data->num_threads ||
-        input_data->compile_something) {
-      pthread_cond_signal(&input_data->coordinator_sleep);
-    }
-    input_data->num_threads_compiling--;
-
-    while(!input_data->compile_something && !input_data->end_yourself) {
-      pthread_cond_wait(&input_data->compiler_thread_sleep, &input_data->mutex);
-    }
-    input_data->num_threads_compiling++;
-    input_data->compile_something = false;
-    has_to_stop = input_data->end_yourself;
-    where_to_add = input_data->where_to_add;
-    pthread_mutex_unlock(&input_data->mutex);
-
-    if (has_to_stop)
+    // Take every pending slot, up to the batch size
+    const size_t batch_size = acr_queue_pop_wait(&input_data->pending,
+        jobs, acr_compile_max_batch);
+    if (batch_size == 0)
       break;
+    for (size_t i = 0; i < batch_size; ++i)
+      batch[i] = jobs[i];
 
 #ifdef ACR_STATS_ENABLED
     acr_time tstart;
@@ -1503,59 +2077,146 @@ static void* acr_runtime_compile_thread(void* in_data) {
 #endif
 
 #ifdef TCC_PRESENT
+    // Promoted slots already run their tcc code
+    size_t tcc_batch_size = 0;
+    for (size_t i = 0; i < batch_size; ++i) {
+      if (atomic_load_explicit(&batch[i]->type, memory_order_relaxed) ==
+          acr_function_proposed_compilation)
+        tcc_batch[tcc_batch_size++] = batch[i];
+    }
     pthread_mutex_lock(&tcc_data.mutex);
-    tcc_data.where_to_add = where_to_add;
     while (tcc_data.compile_something == true) {
       pthread_cond_wait(&tcc_data.waking_up, &tcc_data.mutex);
     }
+    tcc_data.batch = tcc_batch;
+    tcc_data.batch_size = tcc_batch_size;
     tcc_data.compile_something = true;
     pthread_cond_signal(&tcc_data.waking_up);
+    if (!input_data->eager_cc) {
+      // The tcc result decides if cc is needed now
+      while (tcc_data.compile_something == true) {
+        pthread_cond_wait(&tcc_data.waking_up, &tcc_data.mutex);
+      }
+    }
     pthread_mutex_unlock(&tcc_data.mutex);
 #endif
-    file =
-      acr_compile_with_system_compiler(
-          NULL,
-          where_to_add->generated_code,
-          input_data->num_cflags,
-          input_data->cflags);
-    if(!file) {
-      fprintf(stderr, "Compiler error\n");
-      exit(EXIT_FAILURE);
+    // Versions already compiled for the same alternatives are reused
+    size_t num_to_compile = 0;
+    for (size_t i = 0; i < batch_size; ++i) {
+      // A version left out of the full cache keeps its own shared object
+      if (batch[i]->uncached_code == NULL)
+        batch[i]->cc_function = acr_version_cache_get_function(
+            input_data->version_cache, batch[i]->version,
+            acr_version_tier_optimized);
+#ifdef TCC_PRESENT
+      // Tiered compilation: a new version runs its tcc code until the
+      // coordinator promotes it
+      deferred[i] = batch[i]->cc_function == NULL && !input_data->eager_cc &&
+        batch[i]->tcc_function != NULL &&
+        atomic_load_explicit(&batch[i]->type, memory_order_relaxed) !=
+        acr_function_proposed_promotion;
+      if (deferred[i])
+        continue;
+#endif
+      if (batch[i]->cc_function == NULL)
+        to_compile[num_to_compile++] = batch[i];
     }
-    void *dlhandle = dlopen(file, RTLD_NOW);
-    if(!dlhandle) {
-      fprintf(stderr, "dlopen error: %s\n", dlerror());
-      exit(EXIT_FAILURE);
+    const bool compiles_something = num_to_compile > 0;
+    acr_time cc_tstart;
+    acr_get_current_time(&cc_tstart);
+#ifdef MIR_PRESENT
+    // The in-memory JIT needs no process, file or dynamic loading. cc only
+    // builds the versions it could not compile.
+    size_t num_left = 0;
+    for (size_t i = 0; i < num_to_compile; ++i) {
+      struct func_value *const where_to_add = to_compile[i];
+      void *function;
+      MIR_context_t context = acr_compile_with_mir(
+          where_to_add->generated_code, "acr_alternative_function", &function);
+      if (context && function) {
+        acr_slot_set_compiled_code(input_data->version_cache, where_to_add,
+            context, acr_unload_mir_context, function);
+      } else {
+        if (context)
+          acr_free_mir_context(context);
+        to_compile[num_left++] = where_to_add;
+      }
     }
-    void *function = dlsym(dlhandle, "acr_alternative_function");
-    if(!function) {
-      fprintf(stderr, "dlsym error: %s\n", dlerror());
-      exit(EXIT_FAILURE);
+    num_to_compile = num_left;
+#endif
+    if (num_to_compile > 1 &&
+        !acr_runtime_compile_and_load(input_data, compile_server, cflags,
+          num_to_compile, to_compile)) {
+#ifdef ACR_STATS_ENABLED
+      num_cc_failures += 1;
+#endif
+    }
+    // A failed compilation is retried on its own in case the failure was
+    // transient or caused by another version of the batch
+    for (size_t i = 0; i < num_to_compile; ++i) {
+      for (size_t attempt = 0; to_compile[i]->cc_function == NULL &&
+          attempt < acr_cc_max_attempts; ++attempt) {
+        if (!acr_runtime_compile_and_load(input_data, compile_server, cflags,
+              1, &to_compile[i])) {
+#ifdef ACR_STATS_ENABLED
+          num_cc_failures += 1;
+#endif
+        }
+      }
     }
 
-    void *old_dlhandle = where_to_add->compiler_specific.shared_obj_lib.dlhandle;
-    where_to_add->
-      compiler_specific.shared_obj_lib.dlhandle = dlhandle;
-    where_to_add->cc_function = function;
+    if (compiles_something) {
+      acr_time cc_tend;
+      acr_get_current_time(&cc_tend);
+      const double cc_time = acr_difftime(cc_tstart, cc_tend);
+      pthread_mutex_lock(&input_data->mutex);
+      input_data->cc_time_estimate = input_data->cc_time_estimate == 0. ?
+        cc_time : input_data->cc_time_estimate * 0.8 + cc_time * 0.2;
+      pthread_mutex_unlock(&input_data->mutex);
+    }
 
-    enum acr_avaliable_function_type t = acr_function_proposed_compilation;
-    if (! atomic_compare_exchange_strong_explicit(
-          &where_to_add->type,
-          &t,
-          acr_function_shared_object_lib,
-          memory_order_release,
-          memory_order_relaxed)) {
-      atomic_store_explicit(
-          &where_to_add->type,
-          acr_function_tcc_and_shared,
-          memory_order_release);
+#ifdef TCC_PRESENT
+    // Both compilers must be done with the slots before publishing their state
+    pthread_mutex_lock(&tcc_data.mutex);
+    while (tcc_data.compile_something == true) {
+      pthread_cond_wait(&tcc_data.waking_up, &tcc_data.mutex);
     }
-    pthread_cond_signal(input_data->coordinator_continue_cond);
-    if(unlink(file) == -1) {
-      perror("unlink");
-      exit(EXIT_FAILURE);
+    pthread_mutex_unlock(&tcc_data.mutex);
+#endif
+    for (size_t i = 0; i < batch_size; ++i) {
+      struct func_value *const where_to_add = batch[i];
+#ifdef TCC_PRESENT
+      if (deferred[i]) {
+        atomic_store_explicit(&where_to_add->type, acr_function_tcc_only,
+            memory_order_release);
+        continue;
+      }
+      if (where_to_add->cc_function == NULL &&
+          where_to_add->tcc_function != NULL) {
+        // Degraded version, run the tcc code until the grid changes
+        where_to_add->cc_function = where_to_add->tcc_function;
+#ifdef ACR_STATS_ENABLED
+        num_degraded_versions += 1;
+#endif
+      }
+      enum acr_avaliable_function_type final_type =
+        acr_function_tcc_and_shared;
+#else
+      enum acr_avaliable_function_type final_type =
+        acr_function_shared_object_lib;
+#endif
+      if (where_to_add->cc_function == NULL) {
+        fprintf(stderr, "[ACR] Warning: Could not compile a kernel version, the"
+            " kernel keeps its current function\n");
+        final_type = acr_function_poisoned;
+#ifdef ACR_STATS_ENABLED
+        num_poisoned_versions += 1;
+#endif
+      }
+      atomic_store_explicit(&where_to_add->type, final_type,
+          memory_order_release);
     }
-    free(file);
+    acr_runtime_wake_coordinator(input_data->coordinator);
 
 #ifdef ACR_STATS_ENABLED
     acr_time tend;
@@ -1563,10 +2224,6 @@ static void* acr_runtime_compile_thread(void* in_data) {
     total_time += acr_difftime(tstart, tend);
     num_mesurement += 1;
 #endif
-
-    if (old_dlhandle)
-      dlclose(old_dlhandle);
-
   }
 
 #ifdef TCC_PRESENT
@@ -1578,14 +2235,25 @@ static void* acr_runtime_compile_thread(void* in_data) {
   pthread_mutex_destroy(&tcc_data.mutex);
   pthread_cond_destroy(&tcc_data.waking_up);
 #endif
+  free(jobs);
+  free(batch);
+  free(to_compile);
+#ifdef TCC_PRESENT
+  free(tcc_batch);
+  free(deferred);
+#endif
 
 #ifdef ACR_STATS_ENABLED
   pthread_mutex_lock(&input_data->mutex);
   input_data->total_time += total_time;
   input_data->num_mesurement += num_mesurement;
+  input_data->num_cc_failures += num_cc_failures;
+  input_data->num_degraded_versions += num_degraded_versions;
+  input_data->num_poisoned_versions += num_poisoned_versions;
 #ifdef TCC_PRESENT
   input_data->total_tcc_time += tcc_data.total_time;
   input_data->num_tcc_mesurement += tcc_data.num_mesurement;
+  input_data->num_tcc_failures += tcc_data.num_failures;
 #endif
   pthread_mutex_unlock(&input_data->mutex);
 #endif
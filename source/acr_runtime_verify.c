@@ -18,41 +18,444 @@
 
 #include "acr/acr_runtime_verify.h"
 
+#include <pthread.h>
 #include <string.h>
 
-bool acr_verify_me(size_t size_buffers,
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define ACR_VERIFY_X86
+#include <immintrin.h>
+#endif
+
+/*
+ * Every verification function has a scalar version and vector versions for
+ * x86 processors. The vector versions are compiled for their instruction set
+ * with the target attribute and selected at runtime once, the scalar version
+ * is the fallback.
+ */
+
+typedef bool (*acr_verify_me_function)(size_t,
+    unsigned char const*restrict, unsigned char const*restrict);
+
+typedef void (*acr_verify_versioning_function)(size_t,
+    unsigned char const*restrict, unsigned char const*restrict,
+    unsigned char *restrict, size_t *restrict, bool *restrict);
+
+// Process the inner cells of a row and return the first unprocessed column
+typedef size_t (*acr_verify_stencil_row_function)(unsigned char, size_t,
+    unsigned char const*restrict, unsigned char const*restrict,
+    unsigned char *restrict, bool *restrict, bool *restrict, size_t *restrict);
+
+static bool acr_verify_me_scalar(size_t size_buffers,
     unsigned char const*const restrict current,
     unsigned char const*const restrict more_recent) {
-  bool same = true;
   for(size_t i = 0; i < size_buffers; i++) {
-    same = same && (current[i] <= more_recent[i]);
+    if (current[i] > more_recent[i])
+      return false;
   }
-  return same;
+  return true;
 }
 
-void acr_verify_versioning(size_t size_buffers,
+static void acr_verify_versioning_scalar(size_t size_buffers,
     unsigned char const*const restrict current,
     unsigned char const*const restrict more_recent,
     unsigned char *restrict maximized_version,
-    size_t num_alternatives,
-    double *delta,
-    bool *still_valid) {
-  size_t total_difference = 0;
-  bool still_valid_local = true;
-
+    size_t *restrict total_difference,
+    bool *restrict still_valid) {
   for(size_t i = 0; i < size_buffers; i++) {
     if (more_recent[i] < current[i]) {
       // Overapprox if recently added
       maximized_version[i] = more_recent[i];
       if (maximized_version[i] > 0)
         maximized_version[i] = (unsigned char) (maximized_version[i] - 1);
-      total_difference += current[i] - more_recent[i] ? 1 : 0;
-      still_valid_local = false;
+      *total_difference += 1;
+      *still_valid = false;
     } else {
       maximized_version[i] = current[i];
-      total_difference += more_recent[i] - current[i] ? 1 : 0;
+      *total_difference += more_recent[i] != current[i] ? 1 : 0;
     }
   }
+}
+
+static size_t acr_verify_stencil_row_scalar(unsigned char max_alt,
+    size_t jsize,
+    unsigned char const*const restrict more_recent_row,
+    unsigned char const*const restrict current_row,
+    unsigned char *restrict new_row,
+    bool *restrict still_valid,
+    bool *restrict required_compilation,
+    size_t *restrict too_much_precision) {
+  (void) max_alt; (void) jsize; (void) more_recent_row; (void) current_row;
+  (void) new_row; (void) still_valid; (void) required_compilation;
+  (void) too_much_precision;
+  return 1;
+}
+
+#ifdef ACR_VERIFY_X86
+
+__attribute__((target("sse4.1")))
+static bool acr_verify_me_sse41(size_t size_buffers,
+    unsigned char const*const restrict current,
+    unsigned char const*const restrict more_recent) {
+  size_t i = 0;
+  for(; i + 16 <= size_buffers; i += 16) {
+    __m128i c = _mm_loadu_si128((__m128i const*) &current[i]);
+    __m128i r = _mm_loadu_si128((__m128i const*) &more_recent[i]);
+    __m128i current_lower_or_equal = _mm_cmpeq_epi8(_mm_max_epu8(c, r), r);
+    if (_mm_movemask_epi8(current_lower_or_equal) != 0xFFFF)
+      return false;
+  }
+  return acr_verify_me_scalar(size_buffers - i, &current[i], &more_recent[i]);
+}
+
+__attribute__((target("avx2")))
+static bool acr_verify_me_avx2(size_t size_buffers,
+    unsigned char const*const restrict current,
+    unsigned char const*const restrict more_recent) {
+  size_t i = 0;
+  for(; i + 32 <= size_buffers; i += 32) {
+    __m256i c = _mm256_loadu_si256((__m256i const*) &current[i]);
+    __m256i r = _mm256_loadu_si256((__m256i const*) &more_recent[i]);
+    __m256i current_lower_or_equal =
+      _mm256_cmpeq_epi8(_mm256_max_epu8(c, r), r);
+    if (_mm256_movemask_epi8(current_lower_or_equal) != -1)
+      return false;
+  }
+  return acr_verify_me_scalar(size_buffers - i, &current[i], &more_recent[i]);
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static bool acr_verify_me_avx512(size_t size_buffers,
+    unsigned char const*const restrict current,
+    unsigned char const*const restrict more_recent) {
+  size_t i = 0;
+  for(; i + 64 <= size_buffers; i += 64) {
+    __m512i c = _mm512_loadu_si512((void const*) &current[i]);
+    __m512i r = _mm512_loadu_si512((void const*) &more_recent[i]);
+    if (_mm512_cmpgt_epu8_mask(c, r) != 0)
+      return false;
+  }
+  return acr_verify_me_scalar(size_buffers - i, &current[i], &more_recent[i]);
+}
+
+__attribute__((target("sse4.1")))
+static void acr_verify_versioning_sse41(size_t size_buffers,
+    unsigned char const*const restrict current,
+    unsigned char const*const restrict more_recent,
+    unsigned char *restrict maximized_version,
+    size_t *restrict total_difference,
+    bool *restrict still_valid) {
+  const __m128i one = _mm_set1_epi8(1);
+  int all_valid = 0xFFFF;
+  size_t i = 0;
+  for(; i + 16 <= size_buffers; i += 16) {
+    __m128i c = _mm_loadu_si128((__m128i const*) &current[i]);
+    __m128i r = _mm_loadu_si128((__m128i const*) &more_recent[i]);
+    __m128i current_lower_or_equal = _mm_cmpeq_epi8(_mm_max_epu8(c, r), r);
+    __m128i maximized = _mm_blendv_epi8(_mm_subs_epu8(r, one), c,
+        current_lower_or_equal);
+    _mm_storeu_si128((__m128i*) &maximized_version[i], maximized);
+    all_valid &= _mm_movemask_epi8(current_lower_or_equal);
+    unsigned int same = (unsigned int) _mm_movemask_epi8(_mm_cmpeq_epi8(c, r));
+    *total_difference += (size_t) __builtin_popcount(~same & 0xFFFFu);
+  }
+  if (all_valid != 0xFFFF)
+    *still_valid = false;
+  acr_verify_versioning_scalar(size_buffers - i, &current[i], &more_recent[i],
+      &maximized_version[i], total_difference, still_valid);
+}
+
+__attribute__((target("avx2")))
+static void acr_verify_versioning_avx2(size_t size_buffers,
+    unsigned char const*const restrict current,
+    unsigned char const*const restrict more_recent,
+    unsigned char *restrict maximized_version,
+    size_t *restrict total_difference,
+    bool *restrict still_valid) {
+  const __m256i one = _mm256_set1_epi8(1);
+  int all_valid = -1;
+  size_t i = 0;
+  for(; i + 32 <= size_buffers; i += 32) {
+    __m256i c = _mm256_loadu_si256((__m256i const*) &current[i]);
+    __m256i r = _mm256_loadu_si256((__m256i const*) &more_recent[i]);
+    __m256i current_lower_or_equal =
+      _mm256_cmpeq_epi8(_mm256_max_epu8(c, r), r);
+    __m256i maximized = _mm256_blendv_epi8(_mm256_subs_epu8(r, one), c,
+        current_lower_or_equal);
+    _mm256_storeu_si256((__m256i*) &maximized_version[i], maximized);
+    all_valid &= _mm256_movemask_epi8(current_lower_or_equal);
+    unsigned int same =
+      (unsigned int) _mm256_movemask_epi8(_mm256_cmpeq_epi8(c, r));
+    *total_difference += (size_t) __builtin_popcount(~same);
+  }
+  if (all_valid != -1)
+    *still_valid = false;
+  acr_verify_versioning_scalar(size_buffers - i, &current[i], &more_recent[i],
+      &maximized_version[i], total_difference, still_valid);
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static void acr_verify_versioning_avx512(size_t size_buffers,
+    unsigned char const*const restrict current,
+    unsigned char const*const restrict more_recent,
+    unsigned char *restrict maximized_version,
+    size_t *restrict total_difference,
+    bool *restrict still_valid) {
+  const __m512i one = _mm512_set1_epi8(1);
+  __mmask64 any_invalid = 0;
+  size_t i = 0;
+  for(; i + 64 <= size_buffers; i += 64) {
+    __m512i c = _mm512_loadu_si512((void const*) &current[i]);
+    __m512i r = _mm512_loadu_si512((void const*) &more_recent[i]);
+    __mmask64 recent_lower = _mm512_cmplt_epu8_mask(r, c);
+    __m512i maximized = _mm512_mask_blend_epi8(recent_lower, c,
+        _mm512_subs_epu8(r, one));
+    _mm512_storeu_si512((void*) &maximized_version[i], maximized);
+    any_invalid |= recent_lower;
+    *total_difference +=
+      (size_t) __builtin_popcountll(_mm512_cmpneq_epu8_mask(c, r));
+  }
+  if (any_invalid)
+    *still_valid = false;
+  acr_verify_versioning_scalar(size_buffers - i, &current[i], &more_recent[i],
+      &maximized_version[i], total_difference, still_valid);
+}
+
+/*
+ * For a cell with Moore minimum m (plus one if lower than max_alt), the most
+ * recent value r and the current optimized value c:
+ *  - the new optimized value is min(m, r)
+ *  - the current version is invalid if m > r and r < c
+ *  - a compilation is required if m <= r and m < c
+ *  - the cell has too much precision if m <= r and m > c
+ */
+
+__attribute__((target("sse4.1")))
+static size_t acr_verify_stencil_row_sse41(unsigned char max_alt,
+    size_t jsize,
+    unsigned char const*const restrict more_recent_row,
+    unsigned char const*const restrict current_row,
+    unsigned char *restrict new_row,
+    bool *restrict still_valid,
+    bool *restrict required_compilation,
+    size_t *restrict too_much_precision) {
+  const __m128i one = _mm_set1_epi8(1);
+  const __m128i max_alt_val = _mm_set1_epi8((char) max_alt);
+  int invalid = 0, required = 0;
+  size_t j = 1;
+  for(; j + 16 < jsize; j += 16) {
+    unsigned char const*const n = &more_recent_row[j] - jsize;
+    unsigned char const*const m = &more_recent_row[j];
+    unsigned char const*const s = &more_recent_row[j] + jsize;
+    __m128i min = _mm_min_epu8(
+        _mm_loadu_si128((__m128i const*) (n - 1)),
+        _mm_loadu_si128((__m128i const*) n));
+    min = _mm_min_epu8(min, _mm_loadu_si128((__m128i const*) (n + 1)));
+    min = _mm_min_epu8(min, _mm_loadu_si128((__m128i const*) (m - 1)));
+    min = _mm_min_epu8(min, _mm_loadu_si128((__m128i const*) (m + 1)));
+    min = _mm_min_epu8(min, _mm_loadu_si128((__m128i const*) (s - 1)));
+    min = _mm_min_epu8(min, _mm_loadu_si128((__m128i const*) s));
+    min = _mm_min_epu8(min, _mm_loadu_si128((__m128i const*) (s + 1)));
+    min = _mm_min_epu8(_mm_adds_epu8(min, one), _mm_max_epu8(min, max_alt_val));
+
+    __m128i r = _mm_loadu_si128((__m128i const*) m);
+    __m128i c = _mm_loadu_si128((__m128i const*) &current_row[j]);
+    _mm_storeu_si128((__m128i*) &new_row[j], _mm_min_epu8(min, r));
+
+    __m128i min_le_r = _mm_cmpeq_epi8(_mm_max_epu8(min, r), r);
+    __m128i c_le_r = _mm_cmpeq_epi8(_mm_max_epu8(c, r), r);
+    __m128i c_le_min = _mm_cmpeq_epi8(_mm_max_epu8(c, min), min);
+    __m128i min_le_c = _mm_cmpeq_epi8(_mm_max_epu8(min, c), c);
+    invalid |= ~_mm_movemask_epi8(_mm_or_si128(min_le_r, c_le_r)) & 0xFFFF;
+    required |= _mm_movemask_epi8(_mm_andnot_si128(c_le_min, min_le_r));
+    *too_much_precision += (size_t) __builtin_popcount(
+        (unsigned int) _mm_movemask_epi8(_mm_andnot_si128(min_le_c, min_le_r)));
+  }
+  if (invalid)
+    *still_valid = false;
+  if (required)
+    *required_compilation = true;
+  return j;
+}
+
+__attribute__((target("avx2")))
+static size_t acr_verify_stencil_row_avx2(unsigned char max_alt,
+    size_t jsize,
+    unsigned char const*const restrict more_recent_row,
+    unsigned char const*const restrict current_row,
+    unsigned char *restrict new_row,
+    bool *restrict still_valid,
+    bool *restrict required_compilation,
+    size_t *restrict too_much_precision) {
+  const __m256i one = _mm256_set1_epi8(1);
+  const __m256i max_alt_val = _mm256_set1_epi8((char) max_alt);
+  int invalid = 0, required = 0;
+  size_t j = 1;
+  for(; j + 32 < jsize; j += 32) {
+    unsigned char const*const n = &more_recent_row[j] - jsize;
+    unsigned char const*const m = &more_recent_row[j];
+    unsigned char const*const s = &more_recent_row[j] + jsize;
+    __m256i min = _mm256_min_epu8(
+        _mm256_loadu_si256((__m256i const*) (n - 1)),
+        _mm256_loadu_si256((__m256i const*) n));
+    min = _mm256_min_epu8(min, _mm256_loadu_si256((__m256i const*) (n + 1)));
+    min = _mm256_min_epu8(min, _mm256_loadu_si256((__m256i const*) (m - 1)));
+    min = _mm256_min_epu8(min, _mm256_loadu_si256((__m256i const*) (m + 1)));
+    min = _mm256_min_epu8(min, _mm256_loadu_si256((__m256i const*) (s - 1)));
+    min = _mm256_min_epu8(min, _mm256_loadu_si256((__m256i const*) s));
+    min = _mm256_min_epu8(min, _mm256_loadu_si256((__m256i const*) (s + 1)));
+    min = _mm256_min_epu8(_mm256_adds_epu8(min, one),
+        _mm256_max_epu8(min, max_alt_val));
+
+    __m256i r = _mm256_loadu_si256((__m256i const*) m);
+    __m256i c = _mm256_loadu_si256((__m256i const*) &current_row[j]);
+    _mm256_storeu_si256((__m256i*) &new_row[j], _mm256_min_epu8(min, r));
+
+    __m256i min_le_r = _mm256_cmpeq_epi8(_mm256_max_epu8(min, r), r);
+    __m256i c_le_r = _mm256_cmpeq_epi8(_mm256_max_epu8(c, r), r);
+    __m256i c_le_min = _mm256_cmpeq_epi8(_mm256_max_epu8(c, min), min);
+    __m256i min_le_c = _mm256_cmpeq_epi8(_mm256_max_epu8(min, c), c);
+    invalid |= ~_mm256_movemask_epi8(_mm256_or_si256(min_le_r, c_le_r));
+    required |= _mm256_movemask_epi8(_mm256_andnot_si256(c_le_min, min_le_r));
+    *too_much_precision += (size_t) __builtin_popcount((unsigned int)
+        _mm256_movemask_epi8(_mm256_andnot_si256(min_le_c, min_le_r)));
+  }
+  if (invalid)
+    *still_valid = false;
+  if (required)
+    *required_compilation = true;
+  return j;
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static size_t acr_verify_stencil_row_avx512(unsigned char max_alt,
+    size_t jsize,
+    unsigned char const*const restrict more_recent_row,
+    unsigned char const*const restrict current_row,
+    unsigned char *restrict new_row,
+    bool *restrict still_valid,
+    bool *restrict required_compilation,
+    size_t *restrict too_much_precision) {
+  const __m512i one = _mm512_set1_epi8(1);
+  const __m512i max_alt_val = _mm512_set1_epi8((char) max_alt);
+  __mmask64 invalid = 0, required = 0;
+  size_t j = 1;
+  for(; j + 64 < jsize; j += 64) {
+    unsigned char const*const n = &more_recent_row[j] - jsize;
+    unsigned char const*const m = &more_recent_row[j];
+    unsigned char const*const s = &more_recent_row[j] + jsize;
+    __m512i min = _mm512_min_epu8(
+        _mm512_loadu_si512((void const*) (n - 1)),
+        _mm512_loadu_si512((void const*) n));
+    min = _mm512_min_epu8(min, _mm512_loadu_si512((void const*) (n + 1)));
+    min = _mm512_min_epu8(min, _mm512_loadu_si512((void const*) (m - 1)));
+    min = _mm512_min_epu8(min, _mm512_loadu_si512((void const*) (m + 1)));
+    min = _mm512_min_epu8(min, _mm512_loadu_si512((void const*) (s - 1)));
+    min = _mm512_min_epu8(min, _mm512_loadu_si512((void const*) s));
+    min = _mm512_min_epu8(min, _mm512_loadu_si512((void const*) (s + 1)));
+    min = _mm512_min_epu8(_mm512_adds_epu8(min, one),
+        _mm512_max_epu8(min, max_alt_val));
+
+    __m512i r = _mm512_loadu_si512((void const*) m);
+    __m512i c = _mm512_loadu_si512((void const*) &current_row[j]);
+    _mm512_storeu_si512((void*) &new_row[j], _mm512_min_epu8(min, r));
+
+    __mmask64 min_le_r = _mm512_cmple_epu8_mask(min, r);
+    invalid |= ~min_le_r & _mm512_cmplt_epu8_mask(r, c);
+    required |= min_le_r & _mm512_cmplt_epu8_mask(min, c);
+    *too_much_precision += (size_t) __builtin_popcountll(
+        min_le_r & _mm512_cmpgt_epu8_mask(min, c));
+  }
+  if (invalid)
+    *still_valid = false;
+  if (required)
+    *required_compilation = true;
+  return j;
+}
+
+#endif // ACR_VERIFY_X86
+
+static struct {
+  acr_verify_me_function verify_me;
+  acr_verify_versioning_function verify_versioning;
+  acr_verify_stencil_row_function verify_stencil_row;
+} acr_verify_functions;
+
+static pthread_once_t acr_verify_functions_once = PTHREAD_ONCE_INIT;
+
+static bool acr_verify_try_implementation(
+    enum acr_verify_implementation implementation) {
+  switch (implementation) {
+    case acr_verify_implementation_scalar:
+      acr_verify_functions.verify_me = acr_verify_me_scalar;
+      acr_verify_functions.verify_versioning = acr_verify_versioning_scalar;
+      acr_verify_functions.verify_stencil_row = acr_verify_stencil_row_scalar;
+      return true;
+#ifdef ACR_VERIFY_X86
+    case acr_verify_implementation_sse41:
+      if (!__builtin_cpu_supports("sse4.1"))
+        return false;
+      acr_verify_functions.verify_me = acr_verify_me_sse41;
+      acr_verify_functions.verify_versioning = acr_verify_versioning_sse41;
+      acr_verify_functions.verify_stencil_row = acr_verify_stencil_row_sse41;
+      return true;
+    case acr_verify_implementation_avx2:
+      if (!__builtin_cpu_supports("avx2"))
+        return false;
+      acr_verify_functions.verify_me = acr_verify_me_avx2;
+      acr_verify_functions.verify_versioning = acr_verify_versioning_avx2;
+      acr_verify_functions.verify_stencil_row = acr_verify_stencil_row_avx2;
+      return true;
+    case acr_verify_implementation_avx512:
+      if (!__builtin_cpu_supports("avx512f") ||
+          !__builtin_cpu_supports("avx512bw"))
+        return false;
+      acr_verify_functions.verify_me = acr_verify_me_avx512;
+      acr_verify_functions.verify_versioning = acr_verify_versioning_avx512;
+      acr_verify_functions.verify_stencil_row = acr_verify_stencil_row_avx512;
+      return true;
+#endif
+    default:
+      return false;
+  }
+}
+
+static void acr_verify_select_functions(void) {
+#ifdef ACR_VERIFY_X86
+  __builtin_cpu_init();
+#endif
+  // From the widest vectors to the scalar fallback
+  for (size_t i = acr_verify_num_implementations; i > 0; --i) {
+    if (acr_verify_try_implementation((enum acr_verify_implementation) (i-1)))
+      break;
+  }
+}
+
+bool acr_verify_use_implementation(
+    enum acr_verify_implementation implementation) {
+  pthread_once(&acr_verify_functions_once, acr_verify_select_functions);
+  return acr_verify_try_implementation(implementation);
+}
+
+bool acr_verify_me(size_t size_buffers,
+    unsigned char const*const restrict current,
+    unsigned char const*const restrict more_recent) {
+  pthread_once(&acr_verify_functions_once, acr_verify_select_functions);
+  return acr_verify_functions.verify_me(size_buffers, current, more_recent);
+}
+
+void acr_verify_versioning(size_t size_buffers,
+    unsigned char const*const restrict current,
+    unsigned char const*const restrict more_recent,
+    unsigned char *restrict maximized_version,
+    size_t num_alternatives,
+    double *delta,
+    bool *still_valid) {
+  pthread_once(&acr_verify_functions_once, acr_verify_select_functions);
+  size_t total_difference = 0;
+  bool still_valid_local = true;
+
+  acr_verify_functions.verify_versioning(size_buffers, current, more_recent,
+      maximized_version, &total_difference, &still_valid_local);
   (void) num_alternatives;
   *delta = (double) total_difference / (double) size_buffers;
   *still_valid = still_valid_local;
@@ -73,7 +476,56 @@ static inline unsigned char get_min_8_val(
 }
 
 // Moore neighbourhood
-#include <stdio.h>
+static inline void acr_verify_2dstencil_cell(
+    unsigned char max_alt,
+    size_t isize, size_t jsize,
+    size_t i, size_t j,
+    unsigned char const*const restrict more_recent,
+    unsigned char const*const restrict current_optimized_version,
+    unsigned char *restrict new_optimized_version,
+    bool *restrict still_valid,
+    bool *restrict required_compilation,
+    size_t *restrict too_much_precision) {
+  size_t n, s, e, w, ne, nw, se, sw;
+  const size_t element_position_2d = i*jsize + j;
+  n  = element_position_2d - jsize;
+  ne = n + 1;
+  nw = n - 1;
+  s  = element_position_2d + jsize;
+  se = s + 1;
+  sw = s - 1;
+  w  = element_position_2d - 1;
+  e  = element_position_2d + 1;
+  unsigned char
+    n_val = i == 0 ? 255 : more_recent[n],
+    s_val = i == (isize-1) ? 255 : more_recent[s],
+    w_val = j == 0 ? 255 : more_recent[w],
+    e_val = j == (jsize-1) ? 255 : more_recent[e],
+    se_val = (i == (isize-1) || j == (jsize-1)) ? 255 : more_recent[se],
+    sw_val = (i == (isize-1) || j == 0) ? 255 : more_recent[sw],
+    ne_val = (i == 0 || j == (jsize-1)) ? 255 : more_recent[ne],
+    nw_val = (i == 0 || j == 0) ? 255 : more_recent[nw];
+
+  unsigned char min = get_min_8_val(
+      n_val, ne_val, nw_val, s_val, se_val, sw_val, e_val, w_val);
+  if (min < max_alt)
+    min ++;
+  if (min > more_recent[element_position_2d]) {
+    if (more_recent[element_position_2d] < current_optimized_version[element_position_2d]) {
+      *still_valid = false;
+    }
+    new_optimized_version[element_position_2d] = more_recent[element_position_2d];
+  } else {
+    if (min < current_optimized_version[element_position_2d]) {
+      *required_compilation = true;
+    } else {
+      if (min > current_optimized_version[element_position_2d]) {
+        *too_much_precision += 1;
+      }
+    }
+    new_optimized_version[element_position_2d] = min;
+  }
+}
 
 void acr_verify_2dstencil(
     unsigned char max_alt,
@@ -83,6 +535,7 @@ void acr_verify_2dstencil(
     unsigned char *restrict new_optimized_version,
     bool *required_compilation,
     bool *still_valid) {
+  pthread_once(&acr_verify_functions_once, acr_verify_select_functions);
 
   bool still_valid_local = true, required_compilation_local = false;
 
@@ -90,47 +543,22 @@ void acr_verify_2dstencil(
   size_t too_much_precision = 0;
 
   for(size_t i = 0; i < isize; ++i) {
-    size_t element_position_i = i*jsize;
-    for(size_t j = 0; j < jsize; ++j) {
-      size_t n, s, e, w, ne, nw, se, sw;
-      const size_t element_position_2d = element_position_i + j;
-      n  = element_position_2d - jsize;
-      ne = n + 1;
-      nw = n - 1;
-      s  = element_position_2d + jsize;
-      se = s + 1;
-      sw = s - 1;
-      w  = element_position_2d - 1;
-      e  = element_position_2d + 1;
-      unsigned char
-        n_val = i == 0 ? 255 : more_recent[n],
-        s_val = i == (isize-1) ? 255 : more_recent[s],
-        w_val = j == 0 ? 255 : more_recent[w],
-        e_val = j == (jsize-1) ? 255 : more_recent[e],
-        se_val = (i == (isize-1) || j == (jsize-1)) ? 255 : more_recent[se],
-        sw_val = (i == (isize-1) || j == 0) ? 255 : more_recent[sw],
-        ne_val = (i == 0 || j == (jsize-1)) ? 255 : more_recent[ne],
-        nw_val = (i == 0 || j == 0) ? 255 : more_recent[nw];
-
-      unsigned char min = get_min_8_val(
-          n_val, ne_val, nw_val, s_val, se_val, sw_val, e_val, w_val);
-      if (min < max_alt)
-        min ++;
-      if (min > more_recent[element_position_2d]) {
-        if (more_recent[element_position_2d] < current_optimized_version[element_position_2d]) {
-          still_valid_local = false;
-        }
-        new_optimized_version[element_position_2d] = more_recent[element_position_2d];
-      } else {
-        if (min < current_optimized_version[element_position_2d]) {
-          required_compilation_local = true;
-        } else {
-          if (min > current_optimized_version[element_position_2d]) {
-            too_much_precision += 1;
-          }
-        }
-        new_optimized_version[element_position_2d] = min;
-      }
+    size_t j = 0;
+    if (i > 0 && i < isize - 1) { // Inner row, the vector version can be used
+      acr_verify_2dstencil_cell(max_alt, isize, jsize, i, j,
+          more_recent, current_optimized_version, new_optimized_version,
+          &still_valid_local, &required_compilation_local, &too_much_precision);
+      const size_t element_position_i = i*jsize;
+      j = acr_verify_functions.verify_stencil_row(max_alt, jsize,
+          &more_recent[element_position_i],
+          &current_optimized_version[element_position_i],
+          &new_optimized_version[element_position_i],
+          &still_valid_local, &required_compilation_local, &too_much_precision);
+    }
+    for(; j < jsize; ++j) {
+      acr_verify_2dstencil_cell(max_alt, isize, jsize, i, j,
+          more_recent, current_optimized_version, new_optimized_version,
+          &still_valid_local, &required_compilation_local, &too_much_precision);
     }
   }
   size_t total_computation = isize * jsize;
@@ -90,7 +90,11 @@ void acr_print_stats(
       "%29s: %f%%\n"
       "%29s: %f%%\n"
       "%29s: %f%%\n"
-      "%29s: %f%%\n"
+      "%29s: %f%%\n\n"
+      "%29s: %zu\n"
+      "%29s: %zu\n"
+      "%29s: %zu\n"
+      "%29s: %zu\n"
       "\n########################################\n\n",
       kernel_prefix,
       "Total time spent",
@@ -148,7 +152,15 @@ void acr_print_stats(
       "% of CC time",
       cc_proportion_of_total*100,
       "% of TCC time",
-      tcc_proportion_of_total*100);
+      tcc_proportion_of_total*100,
+      "Failed cc invocations",
+      thread_stats->num_cc_failures,
+      "Failed tcc invocations",
+      thread_stats->num_tcc_failures,
+      "Versions degraded to tcc",
+      thread_stats->num_degraded_versions,
+      "Versions without compilation",
+      thread_stats->num_poisoned_versions);
 
 }
 
@@ -437,7 +437,7 @@ static void acr_print_get_alternetive_from_val(
     size_t *strategy_to_alternative_index) {
 
   fprintf(out, "static struct runtime_alternative *%s_alternative_fun[%u] = {\n",
-      prefix, UCHAR_MAX);
+      prefix, UCHAR_MAX + 1);
   intmax_t max_current;
   intmax_t min_current;
   bool not_first_alternative = false;
@@ -749,7 +749,26 @@ char const*const acr_kernel_strategy_type_string[acr_runtime_kernel_unknown] =
     [acr_runtime_kernel_stencil]     = "acr_kernel_strategy_stencil",
   };
 
-static char* acr_static_scan_code_corpse(const acr_option monitor) {
+// The iterator of the innermost monitor dimension, in the first statement
+// nested deep enough
+static const char* acr_innermost_monitor_iterator(const osl_scop_p scop,
+    size_t first_monitor_dimension, size_t num_monitor_dims) {
+  const size_t innermost = first_monitor_dimension + num_monitor_dims - 1;
+  for (osl_statement_p statement = scop->statement; statement;
+      statement = statement->next) {
+    const osl_body_p body =
+      osl_generic_lookup(statement->extension, OSL_URI_BODY);
+    if (innermost < osl_strings_size(body->iterators))
+      return body->iterators->string[innermost];
+  }
+  return NULL;
+}
+
+// A tile function can compute several tiles along the innermost monitor
+// dimension, each value goes to the precision of its tile
+static char* acr_static_scan_code_corpse(const acr_option monitor,
+    const char *innermost_iterator, size_t num_monitor_dims,
+    uintmax_t grid_size) {
   char *retbuffer;
   size_t retbuffer_size;
   FILE *tmp_stream = open_memstream(&retbuffer, &retbuffer_size);
@@ -766,19 +785,28 @@ static char* acr_static_scan_code_corpse(const acr_option monitor) {
     fprintf(tmp_stream, "[%s]", identifier);
   }
   fprintf(tmp_stream, ");");
+  fprintf(tmp_stream,
+      " const size_t __acr_tile_offset ="
+      " (size_t) (%s - acr_monitor_dimension_lower_%zu) / %ju;",
+      innermost_iterator, num_monitor_dims, grid_size);
 
   switch(acr_monitor_get_function(monitor)) {
     case acr_monitor_function_min:
       fprintf(tmp_stream,
-          " __acr_tmp = __acr_tmp < __acr_char_val ? __acr_tmp : __acr_char_val;");
+          " __acr_tmp[__acr_tile_offset] ="
+          " __acr_tmp[__acr_tile_offset] < __acr_char_val ?"
+          " __acr_tmp[__acr_tile_offset] : __acr_char_val;");
       break;
     case acr_monitor_function_max:
       fprintf(tmp_stream,
-          " __acr_tmp = __acr_tmp > __acr_char_val ? __acr_tmp : __acr_char_val;");
+          " __acr_tmp[__acr_tile_offset] ="
+          " __acr_tmp[__acr_tile_offset] > __acr_char_val ?"
+          " __acr_tmp[__acr_tile_offset] : __acr_char_val;");
       break;
     case acr_monitor_function_avg:
       fprintf(tmp_stream,
-          " __acr_tmp += __acr_char_val; __acr_num_values += 1;");
+          " __acr_tmp[__acr_tile_offset] += __acr_char_val;"
+          " __acr_num_values[__acr_tile_offset] += 1;");
       break;
     case acr_monitor_function_unknown:
       break;
@@ -834,11 +862,18 @@ static bool acr_print_static_runtime_init(FILE* out,
   fprintf(out,
       "static struct acr_runtime_data_static %s_static_runtime = {\n"
       "  .is_uninitialized = true,\n"
+      "  .name = \"%s\",\n"
+      "  .num_alternatives = %zu,\n"
       "  .total_functions = 0,\n"
       "  .min_max = NULL,\n"
+      "  .tile_origins = NULL,\n"
+      "  .tile_order = NULL,\n"
+      "  .wavefront_start = NULL,\n"
+      "  .num_wavefronts = 0,\n"
       "  .num_monitor_dimensions = %zu,\n"
       "  .grid_size = %zu\n};\n"
-      , prefix, num_monitor_dims, acr_grid_get_grid_size(grid));
+      , prefix, prefix, num_alternatives, num_monitor_dims,
+      acr_grid_get_grid_size(grid));
 
   return true;
 }
@@ -868,7 +903,9 @@ static void acr_print_acr_runtime_init(FILE* out,
   }
 
   acr_option grid = acr_compute_node_get_option_of_type(acr_type_grid, node, 1);
-  fprintf(out, "static void %s_monitoring_function(unsigned char*);\n", prefix);
+  fprintf(out,
+      "static void %s_monitoring_function(unsigned char*, long, long);\n",
+      prefix);
 
   fprintf(out,
       "#ifdef ACR_STATS_ENABLED\n"
@@ -967,8 +1004,31 @@ static void acr_print_acr_runtime_init(FILE* out,
       fprintf(out, "  .generate_optimum_function = false,\n");
   }
 
+  acr_option monitor =
+    acr_compute_node_get_option_of_type(acr_type_monitor, node, 1);
+  if (monitor && acr_monitor_get_incremental(monitor)) {
+      fprintf(out, "  .incremental_monitoring = true,\n");
+  } else {
+      fprintf(out, "  .incremental_monitoring = false,\n");
+  }
+
   fprintf(out, "};\n");
 
+  switch (build_options->type) {
+    case acr_regular_build:
+    case acr_optimal_generate:
+      // The servers are forked before the simulation allocates its data
+      fprintf(out,
+          "__attribute__((constructor))\n"
+          "static void %s_acr_prespawn_compile_servers(void) {\n"
+          "  acr_runtime_prespawn_compile_servers();\n"
+          "}\n", prefix);
+      break;
+    case acr_static_kernel:
+    case acr_optimal_run:
+      break;
+  }
+
   fprintf(out, "static void %s_acr_runtime_init", prefix);
   acr_print_parameters(out, init);
   fprintf(out, " {\n");
@@ -1074,45 +1134,140 @@ bool acr_print_node_initialization(FILE* in, FILE* out,
   return true;
 }
 
+// Call the alternative given by the precision of a tile, over the tile or
+// over the pending run of tiles along the innermost monitor dimension
+static void acr_print_static_alternative_call(FILE* out,
+    const acr_compute_node node,
+    size_t num_monitor_dims,
+    uintmax_t grid_size,
+    const char *tile_index,
+    bool run) {
+  const char* prefix = acr_get_scop_prefix(node);
+  acr_option init = acr_compute_node_get_option_of_type(acr_type_init, node, 1);
+  fprintf(out,
+      "  _acr_%s_alternatives[%s_static_runtime.precision_array[%s]]",
+      prefix, prefix, tile_index);
+  struct acr_build_options build_options;
+  build_options.type = acr_static_kernel;
+  acr_print_init_function_call(out, init, &build_options);
+  if(fseek(out, ftell(out)-3, SEEK_SET)) {
+    perror("fseek");
+    exit(1);
+  }
+  for (size_t j = 0; j < num_monitor_dims; ++j) {
+    if (!run) {
+      fprintf(out, ", acr_monitor_dimension_lower_%zu"
+          ", acr_monitor_dimension_upper_%zu", j+1, j+1);
+    } else if (j+1 < num_monitor_dims) {
+      fprintf(out, ", __acr_run_lower_%zu, __acr_run_lower_%zu + %ju",
+          j+1, j+1, grid_size-1);
+    } else {
+      fprintf(out, ", __acr_run_lower_%zu"
+          ", __acr_run_lower_%zu + (intmax_t) __acr_run_length_ * %ju - 1",
+          j+1, j+1, grid_size);
+    }
+  }
+  fprintf(out,
+      ", &%s_static_runtime.precision_array[%s]);\n"
+      ,prefix, tile_index);
+}
+
+static void acr_print_static_run_flush(FILE* out,
+    const acr_compute_node node,
+    size_t num_monitor_dims,
+    uintmax_t grid_size) {
+  fprintf(out, "if (__acr_run_length_ > 0)\n");
+  acr_print_static_alternative_call(out, node, num_monitor_dims, grid_size,
+      "__acr_run_start_", true);
+}
+
 static void acr_print_static_function_call(FILE* out,
     const acr_compute_node node,
-    size_t num_monitor_dims) {
+    size_t num_monitor_dims,
+    uintmax_t grid_size,
+    enum acr_tile_schedule schedule) {
 
-  size_t num_alternatives = 0;
-  size_t size_list = acr_compute_node_get_option_list_size(node);
-  acr_option_list options = acr_compute_node_get_option_list(node);
-  for (size_t i = 0; i < size_list; ++i) {
-    acr_option current_option = acr_option_list_get_option(i, options);
-    if (acr_option_get_type(current_option) == acr_type_alternative) {
-      ++num_alternatives;
-    }
+  const char* prefix = acr_get_scop_prefix(node);
+  switch (schedule) {
+    case acr_tile_schedule_sequential:
+      // The tiles following each other along the innermost monitor dimension
+      // with the same precision are computed by a single call
+      fprintf(out,
+          "if (__acr_run_length_ > 0 &&\n"
+          "    %s_static_runtime.precision_array[__acr_iterator_] ==\n"
+          "      %s_static_runtime.precision_array[__acr_run_start_]",
+          prefix, prefix);
+      for (size_t j = 0; j+1 < num_monitor_dims; ++j) {
+        fprintf(out, " &&\n    acr_monitor_dimension_lower_%zu =="
+            " __acr_run_lower_%zu", j+1, j+1);
+      }
+      fprintf(out,
+          " &&\n    acr_monitor_dimension_lower_%zu ==\n"
+          "      __acr_run_lower_%zu + (intmax_t) __acr_run_length_ * %ju) {\n"
+          "  __acr_run_length_++;\n"
+          "} else {\n",
+          num_monitor_dims, num_monitor_dims, grid_size);
+      acr_print_static_run_flush(out, node, num_monitor_dims, grid_size);
+      fprintf(out,
+          "  __acr_run_start_ = __acr_iterator_;\n"
+          "  __acr_run_length_ = 1;\n");
+      for (size_t j = 0; j < num_monitor_dims; ++j) {
+        fprintf(out,
+            "  __acr_run_lower_%zu = acr_monitor_dimension_lower_%zu;\n",
+            j+1, j+1);
+      }
+      fprintf(out, "}\n__acr_iterator_++;");
+      break;
+    case acr_tile_schedule_parallel:
+      // A task computes the tile, the iterator is only advanced by the thread
+      // scanning the tiles
+      fprintf(out,
+          "const size_t __acr_tile_ = __acr_iterator_++;\n"
+          "#pragma omp task\n"
+          "{\n");
+      acr_print_static_alternative_call(out, node, num_monitor_dims,
+          grid_size, "__acr_tile_", false);
+      fprintf(out, "}");
+      break;
+    case acr_tile_schedule_wavefront:
+      acr_print_static_alternative_call(out, node, num_monitor_dims,
+          grid_size, "__acr_tile_", false);
+      break;
   }
+}
 
+// The tiles of a wavefront are computed in parallel, the implicit barrier of
+// the worksharing loop separates the wavefronts
+static void acr_print_static_wavefront_loop(FILE* out,
+    const acr_compute_node node,
+    size_t num_monitor_dims,
+    uintmax_t grid_size) {
   const char* prefix = acr_get_scop_prefix(node);
   fprintf(out,
-      "  switch (%s_static_runtime.precision_array[__acr_iterator_]) {\n", prefix);
-  acr_option init = acr_compute_node_get_option_of_type(acr_type_init, node, 1);
-  for (size_t i = 0; i < num_alternatives; ++i) {
-    fprintf(out, "    case %zu:\n"
-                 "      _acr_%s_alternative_%zu",
-        i, prefix, i);
-    struct acr_build_options build_options;
-    build_options.type = acr_static_kernel;
-    acr_print_init_function_call(out, init, &build_options);
-    if(fseek(out, ftell(out)-3, SEEK_SET)) {
-      perror("fseek");
-      exit(1);
-    }
-    for (size_t j = 0; j < num_monitor_dims; ++j) {
-      fprintf(out, ", acr_monitor_dimension_lower_%zu"
-          ", acr_monitor_dimension_upper_%zu", j+1, j+1);
-    }
+      "#pragma omp parallel\n"
+      "for (size_t __acr_wavefront_ = 0;\n"
+      "    __acr_wavefront_ < %s_static_runtime.num_wavefronts;\n"
+      "    ++__acr_wavefront_) {\n"
+      "#pragma omp for schedule(dynamic)\n"
+      "  for (size_t __acr_position_ =\n"
+      "        %s_static_runtime.wavefront_start[__acr_wavefront_];\n"
+      "      __acr_position_ <\n"
+      "        %s_static_runtime.wavefront_start[__acr_wavefront_+1];\n"
+      "      ++__acr_position_) {\n"
+      "  const size_t __acr_tile_ =\n"
+      "    %s_static_runtime.tile_order[__acr_position_];\n",
+      prefix, prefix, prefix, prefix);
+  for (size_t i = 0; i < num_monitor_dims; ++i) {
     fprintf(out,
-        ", &%s_static_runtime.precision_array[__acr_iterator_]);\n"
-        ,prefix);
-    fprintf(out, "    break;\n");
-  }
-  fprintf(out, "  }\n  __acr_iterator_++;");
+        "  intmax_t acr_monitor_dimension_lower_%zu =\n"
+        "    %s_static_runtime.tile_origins[__acr_tile_ * %zu + %zu];\n"
+        "  intmax_t acr_monitor_dimension_upper_%zu =\n"
+        "    acr_monitor_dimension_lower_%zu + %ju;\n",
+        i+1, prefix, num_monitor_dims, i, i+1, i+1, grid_size-1);
+  }
+  acr_print_static_function_call(out, node, num_monitor_dims, grid_size,
+      acr_tile_schedule_wavefront);
+  fprintf(out, "  }\n}\n");
 }
 
 void acr_print_node_init_function_call(FILE* out,
@@ -1124,7 +1279,31 @@ void acr_print_node_init_function_call(FILE* out,
       "  acr_get_current_time(&t0);\n"
       "#endif\n");
   acr_option init = acr_compute_node_get_option_of_type(acr_type_init, node, 1);
+  // The clock is only read while the coordinator evaluates a function
+  fprintf(out,
+      "  void *acr_timed_function = (void *) %s;\n"
+      "  const bool acr_time_kernel_call = atomic_load_explicit(\n"
+      "      &%s_runtime_data.time_kernel_calls, memory_order_relaxed);\n"
+      "  acr_time kernel_t0;\n"
+      "  if (acr_time_kernel_call)\n"
+      "    acr_get_current_time(&kernel_t0);\n",
+      acr_init_get_function_name(init), prefix);
   acr_print_init_function_call(out, init, b_options);
+  fprintf(out,
+      "  if (acr_time_kernel_call) {\n"
+      "    acr_time kernel_t1;\n"
+      "    acr_get_current_time(&kernel_t1);\n"
+      "    acr_runtime_record_kernel_time(&%s_runtime_data, acr_timed_function,\n"
+      "        acr_difftime(kernel_t0, kernel_t1));\n"
+      "  }\n",
+      prefix);
+  acr_option monitor =
+    acr_compute_node_get_option_of_type(acr_type_monitor, node, 1);
+  if (monitor && acr_monitor_get_incremental(monitor)) {
+    fprintf(out,
+        "  acr_runtime_mark_computed_tiles_dirty(&%s_runtime_data);\n",
+        prefix);
+  }
 
   fprintf(out, "  acr_time sim_step_t2;\n"
       "  acr_get_current_time(&sim_step_t2);\n"
@@ -1142,23 +1321,23 @@ void acr_print_node_init_function_call(FILE* out,
         "  %s_runtime_data.acr_stats->sim_stats.total_time += acr_difftime(t0, t1);\n"
         "  %s_runtime_data.acr_stats->sim_stats.num_simmulation_step += 1;\n"
         "#endif\n"
-        "  pthread_cond_signal(&%s_runtime_data.monitor_sleep_cond);\n",
+        "  acr_runtime_wake_monitor(&%s_runtime_data);\n",
         prefix, prefix, prefix);
   if (b_options->type == acr_optimal_generate) {
     fprintf(out,
-        "  void *acr_potential_new_function = NULL;\n"
-        "  do {\n"
-        "    acr_potential_new_function = atomic_exchange_explicit(\n"
-        "      &%s_runtime_data.alternative_function, NULL,\n"
-        "      memory_order_relaxed);\n"
-        "  } while(acr_potential_new_function == NULL);\n",
+        "  void *acr_potential_new_function =\n"
+        "    acr_runtime_wait_alternative_function(&%s_runtime_data);\n",
         prefix);
   } else {
+    // Only pay for the lock when the coordinator proposes a function
     fprintf(out,
-        "  void *acr_potential_new_function = atomic_exchange_explicit(\n"
-        "      &%s_runtime_data.alternative_function, NULL,\n"
-        "      memory_order_relaxed);\n",
-        prefix);
+        "  void *acr_potential_new_function = atomic_load_explicit(\n"
+        "      &%s_runtime_data.alternative_function, memory_order_relaxed);\n"
+        "  if (acr_potential_new_function != NULL) {\n"
+        "    acr_potential_new_function =\n"
+        "      acr_runtime_take_alternative_function(&%s_runtime_data);\n"
+        "  }\n",
+        prefix, prefix);
   }
   fprintf(out,
         "  if (acr_potential_new_function != NULL) {\n"
@@ -1392,6 +1571,161 @@ static void acr_set_dimension_to_value(
   *map = isl_map_add_constraint(*map, c);
 }
 
+static const char *const acr_monitor_tile_range_names[2] = {
+  "__acr_monitor_first_tile",
+  "__acr_monitor_last_tile",
+};
+
+// Restrict the outermost tile dimension (c2) to the tiles in
+// [__acr_monitor_first_tile, __acr_monitor_last_tile[ so that the monitoring
+// function can be split between multiple threads.
+static void acr_restrict_monitor_to_tile_range(
+    CloogUnionDomain *ud,
+    CloogDomain **context) {
+  const unsigned int first_param = (unsigned int) ud->n_name[CLOOG_PARAM];
+
+  isl_set *context_isl = (isl_set*) *context;
+  context_isl = isl_set_add_dims(context_isl, isl_dim_param, 2);
+  for (unsigned int i = 0; i < 2; ++i) {
+    context_isl = isl_set_set_dim_name(context_isl, isl_dim_param,
+        first_param + i, acr_monitor_tile_range_names[i]);
+  }
+  isl_constraint *c = isl_constraint_alloc_inequality(
+      isl_local_space_from_space(isl_set_get_space(context_isl)));
+  c = isl_constraint_set_coefficient_si(c, isl_dim_param, (int)first_param, 1);
+  context_isl = isl_set_add_constraint(context_isl, c);
+  *context = (CloogDomain*) context_isl;
+
+  for (CloogNamedDomainList *statement = ud->domain;
+      statement != NULL; statement = statement->next) {
+    isl_set *domain = (isl_set*) statement->domain;
+    isl_map *scattering = (isl_map*) statement->scattering;
+    domain = isl_set_add_dims(domain, isl_dim_param, 2);
+    scattering = isl_map_add_dims(scattering, isl_dim_param, 2);
+    for (unsigned int i = 0; i < 2; ++i) {
+      domain = isl_set_set_dim_name(domain, isl_dim_param,
+          first_param + i, acr_monitor_tile_range_names[i]);
+      scattering = isl_map_set_dim_name(scattering, isl_dim_param,
+          first_param + i, acr_monitor_tile_range_names[i]);
+    }
+    isl_local_space *lspace =
+      isl_local_space_from_space(isl_map_get_space(scattering));
+    // c2 - first >= 0
+    c = isl_constraint_alloc_inequality(isl_local_space_copy(lspace));
+    c = isl_constraint_set_coefficient_si(c, isl_dim_out, 1, 1);
+    c = isl_constraint_set_coefficient_si(c, isl_dim_param, (int)first_param, -1);
+    scattering = isl_map_add_constraint(scattering, c);
+    // last - 1 - c2 >= 0
+    c = isl_constraint_alloc_inequality(lspace);
+    c = isl_constraint_set_coefficient_si(c, isl_dim_out, 1, -1);
+    c = isl_constraint_set_coefficient_si(c, isl_dim_param, (int)first_param+1, 1);
+    c = isl_constraint_set_constant_si(c, -1);
+    scattering = isl_map_add_constraint(scattering, c);
+    statement->domain = (CloogDomain*) domain;
+    statement->scattering = (CloogScattering*) scattering;
+  }
+
+  ud->name[CLOOG_PARAM] = realloc(ud->name[CLOOG_PARAM],
+      (first_param + 2) * sizeof(*ud->name[CLOOG_PARAM]));
+  for (unsigned int i = 0; i < 2; ++i) {
+    ud->name[CLOOG_PARAM][first_param + i] =
+      acr_strdup(acr_monitor_tile_range_names[i]);
+  }
+  ud->n_name[CLOOG_PARAM] += 2;
+}
+
+// Number of elements read in each dimension of a tile so that at most
+// sampling elements are read per tile.
+static size_t acr_monitor_samples_per_dimension(
+    size_t grid_size,
+    size_t num_monitor_dims,
+    size_t sampling) {
+  size_t samples = 1;
+  while (samples < grid_size) {
+    size_t total = 1;
+    for (size_t i = 0; i < num_monitor_dims && total <= sampling; ++i) {
+      total *= samples + 1;
+    }
+    if (total > sampling)
+      break;
+    samples += 1;
+  }
+  return samples;
+}
+
+// Only read the elements of a tile whose offset in the tile is a multiple of
+// the sampling stride. The first element of the tile is always read, which is
+// the one used by the initialization statement.
+static void acr_restrict_monitor_to_samples(
+    size_t grid_size,
+    size_t num_monitor_dims,
+    size_t sampling,
+    isl_map **scattering) {
+  const size_t samples =
+    acr_monitor_samples_per_dimension(grid_size, num_monitor_dims, sampling);
+  const size_t stride = (grid_size + samples - 1) / samples;
+  if (stride <= 1)
+    return;
+
+  for (size_t i = 0; i < num_monitor_dims; ++i) {
+    // grid_size * tile + stride * e = value
+    const unsigned int existential = isl_map_dim(*scattering, isl_dim_out);
+    *scattering = isl_map_add_dims(*scattering, isl_dim_out, 1);
+    isl_constraint *c = isl_constraint_alloc_equality(
+        isl_local_space_from_space(isl_map_get_space(*scattering)));
+    c = isl_constraint_set_coefficient_si(c, isl_dim_out,
+        (int)(i*2+1), (int)grid_size);
+    c = isl_constraint_set_coefficient_si(c, isl_dim_out,
+        (int)existential, (int)stride);
+    c = isl_constraint_set_coefficient_si(c, isl_dim_out,
+        (int)(i*2+1+num_monitor_dims*2), -1);
+    *scattering = isl_map_add_constraint(*scattering, c);
+    *scattering =
+      isl_map_project_out(*scattering, isl_dim_out, existential, 1);
+  }
+}
+
+// Static kernels scan the data inside the tile functions, the elements read
+// are the ones whose offset in their tile is a multiple of the stride
+static isl_set* acr_restrict_static_scan_to_samples(
+    size_t grid_size,
+    size_t num_monitor_dims,
+    size_t sampling,
+    isl_set *domain) {
+  const size_t samples =
+    acr_monitor_samples_per_dimension(grid_size, num_monitor_dims, sampling);
+  const size_t stride = (grid_size + samples - 1) / samples;
+  if (stride <= 1)
+    return domain;
+
+  for (size_t i = 0; i < num_monitor_dims; ++i) {
+    // value = grid_size * tile + stride * e, 0 <= stride * e < grid_size
+    const unsigned int tile = isl_set_dim(domain, isl_dim_set);
+    domain = isl_set_add_dims(domain, isl_dim_set, 2);
+    isl_space *space = isl_set_get_space(domain);
+    isl_constraint *c = isl_constraint_alloc_equality(
+        isl_local_space_from_space(isl_space_copy(space)));
+    c = isl_constraint_set_coefficient_si(c, isl_dim_set, (int)i, -1);
+    c = isl_constraint_set_coefficient_si(c, isl_dim_set,
+        (int)tile, (int)grid_size);
+    c = isl_constraint_set_coefficient_si(c, isl_dim_set,
+        (int)tile+1, (int)stride);
+    domain = isl_set_add_constraint(domain, c);
+    c = isl_constraint_alloc_inequality(
+        isl_local_space_from_space(isl_space_copy(space)));
+    c = isl_constraint_set_coefficient_si(c, isl_dim_set,
+        (int)tile+1, (int)stride);
+    domain = isl_set_add_constraint(domain, c);
+    c = isl_constraint_alloc_inequality(isl_local_space_from_space(space));
+    c = isl_constraint_set_coefficient_si(c, isl_dim_set,
+        (int)tile+1, -(int)stride);
+    c = isl_constraint_set_constant_si(c, (int)grid_size-1);
+    domain = isl_set_add_constraint(domain, c);
+    domain = isl_set_project_out(domain, isl_dim_set, tile, 2);
+  }
+  return domain;
+}
+
 static void acr_modify_main_statement_for_test_type(
     size_t tiling_size,
     size_t num_monitor_dims,
@@ -1482,9 +1816,17 @@ static bool acr_print_scanning_function(FILE* out, const acr_compute_node node,
   acr_print_acr_runtime_init(out, node, dims, bound_used, scop,
       build_options);
 
+  // CLooG uses min and max when the tile range cuts the loop bounds
   fprintf(out,
-      "static void %s_monitoring_function(unsigned char* monitor_result) {\n",
-      prefix);
+      "#pragma push_macro(\"max\")\n"
+      "#pragma push_macro(\"min\")\n"
+      "#undef max\n"
+      "#undef min\n"
+      "#define max(a,b) (((a)>(b))?(a):(b))\n"
+      "#define min(a,b) (((a)<(b))?(a):(b))\n"
+      "static void %s_monitoring_function(unsigned char* monitor_result,\n"
+      "    long %s, long %s) {\n",
+      prefix, acr_monitor_tile_range_names[0], acr_monitor_tile_range_names[1]);
   switch (acr_monitor_get_function(monitor)) {
     case acr_monitor_function_min:
     case acr_monitor_function_max:
@@ -1538,11 +1880,17 @@ static bool acr_print_scanning_function(FILE* out, const acr_compute_node node,
       mon_statements,
       new_scop,
       &new_ud);
+  // The main statement is the first one of the union
+  const size_t sampling = acr_monitor_get_sampling(monitor);
+  if (sampling)
+    acr_restrict_monitor_to_samples(grid_size, num_monitor_dims, sampling,
+        (isl_map**) &new_ud->domain->scattering);
 
   new_ud->n_name[CLOOG_PARAM] = cloog_input->ud->n_name[CLOOG_PARAM];
   new_ud->name[CLOOG_PARAM] = cloog_input->ud->name[CLOOG_PARAM];
   cloog_input->ud->n_name[CLOOG_PARAM] = 0;
   cloog_input->ud->name[CLOOG_PARAM] = NULL;
+  acr_restrict_monitor_to_tile_range(new_ud, &new_context);
 
   CloogOptions *cloog_option = cloog_options_malloc(cloog_state);
   cloog_option->quiet = 1;
@@ -1550,12 +1898,18 @@ static bool acr_print_scanning_function(FILE* out, const acr_compute_node node,
   cloog_option->scop = new_scop;
   cloog_option->otl = 1;
   cloog_option->language = 0;
+  cloog_option->strides = 1;
   CloogProgram *cloog_program = cloog_program_alloc(new_context,
       new_ud, cloog_option);
   cloog_program = cloog_program_generate(cloog_program, cloog_option);
 
   cloog_program_pprint(out, cloog_program, cloog_option);
-  fprintf(out, "}\n");
+  fprintf(out,
+      "}\n"
+      "#undef max\n"
+      "#undef min\n"
+      "#pragma pop_macro(\"max\")\n"
+      "#pragma pop_macro(\"min\")\n");
 
   cloog_union_domain_free(cloog_input->ud);
   cloog_domain_free(cloog_input->context);
@@ -1713,7 +2067,8 @@ static void acr_print_static_tiled_scop_function(
 static void acr_print_static_main_function(
     FILE* out,
     osl_scop_p scop,
-    acr_compute_node node) {
+    acr_compute_node node,
+    enum acr_tile_schedule schedule) {
 
   size_t first_monitor_dimension, num_monitor_dims;
   acr_openscop_get_monitoring_position_and_num(
@@ -1804,24 +2159,35 @@ static void acr_print_static_main_function(
   char *corpse_string;
   size_t retbuffer_size;
   FILE *corpse_stream = open_memstream(&corpse_string, &retbuffer_size);
+  const char* prefix = acr_get_scop_prefix(node);
   for (size_t i = 0; i < num_monitor_dims; ++i) {
     osl_strings_add(osl_iterators, iterators_names[i]);
-    fprintf(corpse_stream, "intmax_t %s = %s;\n intmax_t %s = %s + %zu;\n",
-        lower_names[i], iterators_names[i],
-        upper_names[i], iterators_names[i], grid_size-1);
+    if (schedule == acr_tile_schedule_wavefront) {
+      // Only record the tiles, they are computed once sorted by wavefront
+      fprintf(corpse_stream,
+          "%s_static_runtime.tile_origins[__acr_iterator_ * %zu + %zu] = %s;\n",
+          prefix, num_monitor_dims, i, iterators_names[i]);
+    } else {
+      fprintf(corpse_stream, "intmax_t %s = %s;\n intmax_t %s = %s + %zu;\n",
+          lower_names[i], iterators_names[i],
+          upper_names[i], iterators_names[i], grid_size-1);
+    }
     free(iterators_names[i]);
     free(upper_names[i]);
     free(lower_names[i]);
   }
   fprintf(out, "  size_t __acr_iterator_ = 0;\n");
-  acr_print_static_function_call(corpse_stream, node, num_monitor_dims);
+  if (schedule == acr_tile_schedule_wavefront)
+    fprintf(corpse_stream, "__acr_iterator_++;");
+  else
+    acr_print_static_function_call(corpse_stream, node, num_monitor_dims,
+        grid_size, schedule);
   fclose(corpse_stream);
   free(iterators_names);
   char *lexmax_string = NULL, *lexmin_string = NULL;
 
   lex_min_max_access_strings(unaffected_domain, &lexmax_string, &lexmin_string);
   isl_set_free(unaffected_domain);
-  const char* prefix = acr_get_scop_prefix(node);
 
   fprintf(out,
       "if (%s_static_runtime.is_uninitialized) {\n"
@@ -1877,7 +2243,39 @@ static void acr_print_static_main_function(
       udgen, cloog_option);
   cloog_program = cloog_program_generate(cloog_program, cloog_option);
 
-  cloog_program_pprint(out, cloog_program, cloog_option);
+  // Without OpenMP the pragmas are ignored and the tiles run in order
+  switch (schedule) {
+    case acr_tile_schedule_sequential:
+      fprintf(out,
+          "size_t __acr_run_start_ = 0, __acr_run_length_ = 0;\n");
+      for (size_t i = 0; i < num_monitor_dims; ++i) {
+        fprintf(out, "intmax_t __acr_run_lower_%zu = 0;\n", i+1);
+      }
+      cloog_program_pprint(out, cloog_program, cloog_option);
+      acr_print_static_run_flush(out, node, num_monitor_dims, grid_size);
+      break;
+    case acr_tile_schedule_parallel:
+      fprintf(out,
+          "#pragma omp parallel\n"
+          "#pragma omp single\n"
+          "{\n");
+      cloog_program_pprint(out, cloog_program, cloog_option);
+      fprintf(out, "}\n");
+      break;
+    case acr_tile_schedule_wavefront:
+      fprintf(out,
+          "if (%s_static_runtime.tile_order == NULL) {\n"
+          "  %s_static_runtime.tile_origins =\n"
+          "    malloc(%s_static_runtime.total_functions * sizeof(intmax_t[%zu]));\n",
+          prefix, prefix, prefix, num_monitor_dims);
+      cloog_program_pprint(out, cloog_program, cloog_option);
+      fprintf(out,
+          "  acr_static_data_init_wavefronts(&%s_static_runtime,"
+          " __acr_iterator_);\n"
+          "}\n", prefix);
+      acr_print_static_wavefront_loop(out, node, num_monitor_dims, grid_size);
+      break;
+  }
 
   cloog_program_free(cloog_program);
   cloog_option->openscop = 0;
@@ -1921,6 +2319,14 @@ static void acr_generate_code_static(
         osl_scop_free(scop->next);
         scop->next = NULL;
       }
+      // The accesses are gone once the scop is simplified
+      size_t first_monitor_dimension, num_monitor_dims;
+      acr_openscop_get_monitoring_position_and_num(
+          node, scop, &first_monitor_dimension, &num_monitor_dims);
+      const enum acr_tile_schedule schedule = acr_osl_get_tile_schedule(
+          scop, first_monitor_dimension, num_monitor_dims,
+          acr_grid_get_grid_size(
+            acr_compute_node_get_option_of_type(acr_type_grid, node, 1)));
       simplify_osl_for_printing(scop);
       acr_delete_alternative_parameters_for_parameter_not_present_in_scop(
           node,
@@ -1969,7 +2375,7 @@ static void acr_generate_code_static(
           position_in_input, kernel_start,
           all_options);
 
-      acr_print_static_main_function(temp_buffer, scop, node);
+      acr_print_static_main_function(temp_buffer, scop, node, schedule);
 
       position_in_input = kernel_end;
       fseek(current_file, (long)position_in_input, SEEK_SET);
@@ -2696,6 +3102,7 @@ static void acr_print_tiling_alternative_function_call(
     size_t alternative_num,
     size_t num_alternatives,
     size_t num_monitor_dims,
+    uintmax_t grid_size,
     const acr_compute_node node,
     enum acr_monitor_processing_funtion process_fun) {
   fprintf(out, "void _acr_%s_alternative_%zu", prefix, alternative_num);
@@ -2710,22 +3117,66 @@ static void acr_print_tiling_alternative_function_call(
                  ", intmax_t acr_monitor_dimension_upper_%zu", i+1, i+1);
   }
   fprintf(out, ", unsigned char *__acr_next_function_precision) {\n");
+  // The tiles of the range along the innermost monitor dimension
+  fprintf(out,
+      "const size_t __acr_num_tiles = (size_t) (acr_monitor_dimension_upper_%zu"
+      " - acr_monitor_dimension_lower_%zu) / %ju + 1;\n",
+      num_monitor_dims, num_monitor_dims, grid_size);
   switch (process_fun) {
     case acr_monitor_function_min:
-      fprintf(out, "unsigned char __acr_tmp = %zu;\n", num_alternatives-1);
+      fprintf(out,
+          "unsigned char __acr_tmp[__acr_num_tiles];\n"
+          "for (size_t __acr_k = 0; __acr_k < __acr_num_tiles; ++__acr_k)\n"
+          "  __acr_tmp[__acr_k] = %zu;\n", num_alternatives-1);
       break;
     case acr_monitor_function_avg:
-      fprintf(out, "size_t __acr_num_values = 0;\n");
-      fprintf(out, "size_t __acr_tmp = 0;\n");
+      fprintf(out,
+          "size_t __acr_num_values[__acr_num_tiles];\n"
+          "size_t __acr_tmp[__acr_num_tiles];\n"
+          "for (size_t __acr_k = 0; __acr_k < __acr_num_tiles; ++__acr_k) {\n"
+          "  __acr_num_values[__acr_k] = 0;\n"
+          "  __acr_tmp[__acr_k] = 0;\n"
+          "}\n");
       break;
     case acr_monitor_function_max:
-      fprintf(out, "unsigned char __acr_tmp = 0;\n");
+      fprintf(out,
+          "unsigned char __acr_tmp[__acr_num_tiles];\n"
+          "for (size_t __acr_k = 0; __acr_k < __acr_num_tiles; ++__acr_k)\n"
+          "  __acr_tmp[__acr_k] = 0;\n");
       break;
     case acr_monitor_function_unknown:
       break;
   }
 }
 
+// The tile functions indexed by precision, the driver calls the one given by
+// the precision of the tile instead of going through a switch
+static void acr_print_tiling_alternative_table(
+    FILE *out,
+    const char *prefix,
+    size_t num_alternatives,
+    size_t num_monitor_dims,
+    const acr_compute_node node) {
+  fprintf(out, "typedef void (*_acr_%s_tile_function)", prefix);
+  acr_option init = acr_compute_node_get_option_of_type(acr_type_init, node, 1);
+  acr_print_parameters(out, init);
+  if(fseek(out, ftell(out)-1, SEEK_SET)) {
+    perror("fseek");
+    exit(1);
+  }
+  for (size_t i = 0; i < num_monitor_dims; ++i) {
+    fprintf(out, ", intmax_t, intmax_t");
+  }
+  fprintf(out, ", unsigned char *);\n");
+  fprintf(out,
+      "static const _acr_%s_tile_function _acr_%s_alternatives[%zu] = {\n",
+      prefix, prefix, num_alternatives);
+  for (size_t i = 0; i < num_alternatives; ++i) {
+    fprintf(out, "  _acr_%s_alternative_%zu,\n", prefix, i);
+  }
+  fprintf(out, "};\n\n");
+}
+
 void acr_generation_generate_tiling_alternatives(
     FILE *out,
     size_t grid_size,
@@ -2807,7 +3258,10 @@ void acr_generation_generate_tiling_alternatives(
 
   acr_option monitor = acr_compute_node_get_option_of_type(acr_type_monitor, node, 1);
 
-  char *scan_code = acr_static_scan_code_corpse(monitor);
+  char *scan_code = acr_static_scan_code_corpse(monitor,
+      acr_innermost_monitor_iterator(scop, first_monitor_dimension,
+        num_monitor_dimensions),
+      num_monitor_dimensions, grid_size);
 
   size_t num_alternatives = 0;
   size_t num_strategy = 0;
@@ -2864,7 +3318,8 @@ void acr_generation_generate_tiling_alternatives(
     }
     enum acr_monitor_processing_funtion process_fun = acr_monitor_get_function(monitor);
     acr_print_tiling_alternative_function_call(
-        out, prefix, i, num_alternatives, num_monitor_dimensions, node, process_fun);
+        out, prefix, i, num_alternatives, num_monitor_dimensions, grid_size,
+        node, process_fun);
     CloogUnionDomain *ud_copy = acr_copy_cloog_ud(ud);
 
     osl_scop_p alternative_scop = osl_scop_clone(scop);
@@ -2881,6 +3336,13 @@ void acr_generation_generate_tiling_alternatives(
         &new_ud, &new_context, &new_scop,
         scan_code, identifiers_id, true);
     free(identifiers_id);
+    const size_t sampling = acr_monitor_get_sampling(monitor);
+    if (sampling) {
+      new_ud->domain->domain = cloog_domain_from_isl_set(
+          acr_restrict_static_scan_to_samples(grid_size,
+            num_monitor_dimensions, sampling,
+            (isl_set*)new_ud->domain->domain));
+    }
 
     ud_copy = cloog_union_domain_add_domain(ud_copy, NULL, new_ud->domain->domain, new_ud->domain->scattering, NULL);
     new_ud->domain->domain = NULL;
@@ -2914,12 +3376,20 @@ void acr_generation_generate_tiling_alternatives(
     cloog_option->scop = NULL;
     free(cloog_option);
     osl_scop_free(alternative_scop);
+    fprintf(out,
+        "for (size_t __acr_k = 0; __acr_k < __acr_num_tiles; ++__acr_k)\n");
     if (process_fun == acr_monitor_function_avg) {
-      fprintf(out, "__acr_tmp /= __acr_num_values;\n");
+      fprintf(out,
+          "  __acr_next_function_precision[__acr_k] =\n"
+          "    (unsigned char) (__acr_tmp[__acr_k] / __acr_num_values[__acr_k]);\n");
+    } else {
+      fprintf(out,
+          "  __acr_next_function_precision[__acr_k] = __acr_tmp[__acr_k];\n");
     }
-    fprintf(out, "*__acr_next_function_precision = __acr_tmp;\n");
     fprintf(out, "}\n\n");
   }
+  acr_print_tiling_alternative_table(out, prefix, num_alternatives,
+      num_monitor_dimensions, node);
   free(strategy_list);
   free(alternative_list);
   free(strategy_to_alternative_index);
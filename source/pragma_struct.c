@@ -160,6 +160,8 @@ acr_option acr_new_monitor(
   option->options.monitor.processing_function = processing_function;
   option->options.monitor.filter_name = acr_strdup(filter_name);
   option->options.monitor.pragma_position = pragma_position;
+  option->options.monitor.sampling = 0;
+  option->options.monitor.incremental = false;
   return option;
 }
 
@@ -864,8 +866,11 @@ acr_option acr_copy_monitor(const acr_option monitor) {
   acr_array_declaration declaration_copy;
   acr_copy_array_declaration(&monitor->options.monitor.data_monitored,
       &declaration_copy);
-  return acr_new_monitor(&declaration_copy, mon->processing_function,
-      mon->filter_name, mon->pragma_position);
+  acr_option new_monitor = acr_new_monitor(&declaration_copy,
+      mon->processing_function, mon->filter_name, mon->pragma_position);
+  acr_monitor_set_sampling(mon->sampling, new_monitor);
+  acr_monitor_set_incremental(mon->incremental, new_monitor);
+  return new_monitor;
 }
 
 acr_option acr_copy_strategy(const acr_option strategy) {
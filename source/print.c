@@ -200,6 +200,17 @@ void pprint_acr_monitor(FILE* out, acr_option monitor, size_t indent_level) {
     pprint_acr_indent(out, indent_level + 2);
     fprintf(out, "| %s\n", filter_function);
   }
+  size_t sampling = acr_monitor_get_sampling(monitor);
+  if (sampling) {
+    pprint_acr_indent(out, indent_level + 1);
+    fprintf(out, "|---| Sampling:\n");
+    pprint_acr_indent(out, indent_level + 2);
+    fprintf(out, "| %zu elements per tile\n", sampling);
+  }
+  if (acr_monitor_get_incremental(monitor)) {
+    pprint_acr_indent(out, indent_level + 1);
+    fprintf(out, "|---| Incremental\n");
+  }
   pprint_acr_indent(out, indent_level);
   fprintf(out, "|\n");
 }
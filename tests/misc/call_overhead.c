@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2016 Maxime Schmitt
+ *
+ * ACR is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+// Time spent by the wrapper acr generates around each kernel call. This file
+// goes through acr at build time, the kernel is small enough for the wrapper
+// to show. The same loop nest without acr gives the reference time.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define M 32
+#define P 1
+
+static const size_t num_warmup_calls = 1000;
+static const size_t num_timed_calls = 200000;
+
+int data[M][M];
+int result[M][M];
+
+static double now(void) {
+  struct timespec time;
+  clock_gettime(CLOCK_MONOTONIC, &time);
+  return (double) time.tv_sec + (double) time.tv_nsec * 1e-9;
+}
+
+static void reference_kernel(void) {
+  for (int k = 0; k < P; ++k)
+    for (int i = 0; i < M; ++i)
+      for (int j = 0; j < M; ++j)
+        result[i][j] = data[i][j] + k;
+}
+
+// Called through a pointer like the kernel of the wrapper
+static void (*volatile reference_call)(void) = reference_kernel;
+
+static double reference_time(void) {
+  for (size_t call = 0; call < num_warmup_calls; ++call)
+    reference_call();
+  const double start = now();
+  for (size_t call = 0; call < num_timed_calls; ++call)
+    reference_call();
+  return (now() - start) / (double) num_timed_calls;
+}
+
+#pragma acr init(void call_overhead_kernel(int k, int i, int j))
+
+static double wrapper_time(void) {
+  int i = 0, j = 0, k = 0;
+  double start = 0.;
+  const size_t num_calls = num_warmup_calls + num_timed_calls;
+  for (size_t call = 0; call < num_calls; ++call) {
+    if (call == num_warmup_calls)
+      start = now();
+#pragma acr grid(8)
+#pragma acr monitor(data[i][j], max)
+#pragma acr alternative low(parameter, P = 1)
+#pragma acr alternative high(parameter, P = 2)
+#pragma acr strategy direct(0, low)
+#pragma acr strategy direct(1, high)
+#pragma scop
+    for (k = 0; k < P; ++k)
+      for (i = 0; i < M; ++i)
+        for (j = 0; j < M; ++j)
+          result[i][j] = data[i][j] + k;
+#pragma endscop
+  }
+  const double elapsed = now() - start;
+#pragma acr destroy
+  return elapsed / (double) num_timed_calls;
+}
+
+int main(void) {
+  const double reference = reference_time();
+  const double wrapped = wrapper_time();
+  printf("kernel alone: %.3f us/call\n", reference * 1e6);
+  printf("acr wrapper:  %.3f us/call\n", wrapped * 1e6);
+  printf("overhead:     %.3f us/call\n", (wrapped - reference) * 1e6);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,55 @@
+/*
+ * Copyright (C) 2016 Maxime Schmitt
+ *
+ * ACR is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+// Built with acr -x and run with compiler flags that make every compilation
+// fail. The kernel waits for the coordinator after each call in optimal
+// generation mode, it must get back the original function and finish.
+
+#include <stdlib.h>
+
+#define M 32
+#define P 1
+
+static const size_t num_calls = 20;
+
+int data[M][M];
+int result[M][M];
+
+#pragma acr init(void optimal_poisoned_kernel(int k, int i, int j))
+
+int main(void) {
+  int i = 0, j = 0, k = 0;
+  for (size_t call = 0; call < num_calls; ++call) {
+    // A new grid each call asks for a new version
+    data[call % M][call % M] = (int) (call % 2);
+#pragma acr grid(8)
+#pragma acr monitor(data[i][j], max)
+#pragma acr alternative low(parameter, P = 1)
+#pragma acr alternative high(parameter, P = 2)
+#pragma acr strategy direct(0, low)
+#pragma acr strategy direct(1, high)
+#pragma scop
+    for (k = 0; k < P; ++k)
+      for (i = 0; i < M; ++i)
+        for (j = 0; j < M; ++j)
+          result[i][j] = data[i][j] + k;
+#pragma endscop
+  }
+#pragma acr destroy
+  return EXIT_SUCCESS;
+}
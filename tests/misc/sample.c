@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2016 Maxime Schmitt
+ *
+ * ACR is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+// Built with acr. With sample(4) on a grid of 8, the monitor reads 2 elements
+// per tile dimension: exactly the elements whose offsets in their tile are
+// multiples of 4. Each element holds its own index so that the filter records
+// which ones were read.
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define M 32
+#define P 1
+#define STRIDE 4
+
+static const size_t max_calls = 10000;
+
+int data[M][M];
+int result[M][M];
+static atomic_bool read_elements[M * M];
+
+static inline unsigned char record_read(int index) {
+  atomic_store(&read_elements[index], true);
+  return 0;
+}
+
+static bool is_sampled(int i, int j) {
+  return i % STRIDE == 0 && j % STRIDE == 0;
+}
+
+static bool every_sample_read(void) {
+  for (int i = 0; i < M; ++i)
+    for (int j = 0; j < M; ++j)
+      if (is_sampled(i, j) && !atomic_load(&read_elements[i * M + j]))
+        return false;
+  return true;
+}
+
+#pragma acr init(void sample_kernel(int k, int i, int j))
+
+int main(void) {
+  int i = 0, j = 0, k = 0;
+  for (i = 0; i < M; ++i)
+    for (j = 0; j < M; ++j)
+      data[i][j] = i * M + j;
+
+  // The monitor scans asynchronously after the calls
+  const struct timespec pause = { .tv_sec = 0, .tv_nsec = 1000000 };
+  for (size_t call = 0; call < max_calls && !every_sample_read(); ++call) {
+#pragma acr grid(8)
+#pragma acr monitor(int data[i][j], max, record_read) sample(4)
+#pragma acr alternative low(parameter, P = 1)
+#pragma acr alternative high(parameter, P = 2)
+#pragma acr strategy direct(0, low)
+#pragma acr strategy direct(1, high)
+#pragma scop
+    for (k = 0; k < P; ++k)
+      for (i = 0; i < M; ++i)
+        for (j = 0; j < M; ++j)
+          result[i][j] = data[i][j] + k;
+#pragma endscop
+    nanosleep(&pause, NULL);
+  }
+#pragma acr destroy
+
+  size_t num_errors = 0;
+  for (i = 0; i < M; ++i) {
+    for (j = 0; j < M; ++j) {
+      if (atomic_load(&read_elements[i * M + j]) != is_sampled(i, j)) {
+        fprintf(stderr, "Element [%d][%d] %s\n", i, j,
+            is_sampled(i, j) ? "never read" : "read but not sampled");
+        num_errors += 1;
+      }
+    }
+  }
+  return num_errors == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,179 @@
+/*
+ * Copyright (C) 2016 Maxime Schmitt
+ *
+ * ACR is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+// The domain of each alternative must be the union of its tiles, whether it
+// is built from the merged rectangles or updated with the tiles that changed
+// since the previous grid
+
+#include "acr/acr_runtime_code_generation.h"
+
+#include <isl/ctx.h>
+#include <isl/space.h>
+#include <stdio.h>
+#include <string.h>
+
+#define NUM_ALTERNATIVES 3
+#define MAX_DIMS 3
+
+static const size_t grid_size = 4;
+static const size_t num_rounds = 50;
+
+static size_t num_errors = 0;
+static struct runtime_alternative alternatives[NUM_ALTERNATIVES];
+
+// Value 3 uses the same alternative as value 0
+static struct runtime_alternative* alternative_from_val(unsigned char value) {
+  return &alternatives[value % NUM_ALTERNATIVES];
+}
+
+static void check(bool condition, const char *test, size_t round,
+    const char *message) {
+  if (!condition) {
+    fprintf(stderr, "%s, round %zu: %s\n", test, round, message);
+    num_errors += 1;
+  }
+}
+
+// Same tiles as the runtime initialization, the last dimension is the fastest
+static struct acr_runtime_data grid_data(isl_ctx *ctx,
+    unsigned int num_dims, unsigned long *dim_max) {
+  struct acr_runtime_data data_info;
+  memset(&data_info, 0, sizeof(data_info));
+  data_info.num_codegen_threads = 1;
+  data_info.num_alternatives = NUM_ALTERNATIVES;
+  data_info.alternatives = alternatives;
+  data_info.num_monitor_dims = num_dims;
+  data_info.monitor_dim_max = dim_max;
+  data_info.grid_size = grid_size;
+  data_info.alternative_from_val = alternative_from_val;
+  data_info.monitor_total_size = 1;
+  for (unsigned int i = 0; i < num_dims; ++i)
+    data_info.monitor_total_size *= dim_max[i];
+
+  isl_space *space = isl_space_set_alloc(ctx, 0, num_dims);
+  data_info.empty_monitor_set = malloc(sizeof(*data_info.empty_monitor_set));
+  data_info.empty_monitor_set[0] = isl_set_empty(isl_space_copy(space));
+  data_info.tiles_domains = malloc(sizeof(*data_info.tiles_domains));
+  data_info.tiles_domains[0] = malloc(data_info.monitor_total_size *
+      sizeof(*data_info.tiles_domains[0]));
+  unsigned long tile[MAX_DIMS] = { 0 };
+  for (size_t i = 0; i < data_info.monitor_total_size; ++i) {
+    data_info.tiles_domains[0][i] = acr_isl_set_tile_box(
+        isl_space_copy(space), grid_size, tile, tile);
+    for (unsigned int j = num_dims; j-- > 0;) {
+      tile[j] += 1;
+      if (tile[j] < dim_max[j])
+        break;
+      tile[j] = 0;
+    }
+  }
+  isl_space_free(space);
+  return data_info;
+}
+
+static void free_grid_data(struct acr_runtime_data *data_info) {
+  for (size_t i = 0; i < data_info->monitor_total_size; ++i)
+    isl_set_free(data_info->tiles_domains[0][i]);
+  free(data_info->tiles_domains[0]);
+  free(data_info->tiles_domains);
+  isl_set_free(data_info->empty_monitor_set[0]);
+  free(data_info->empty_monitor_set);
+}
+
+// Build the sets and compare them with the union of the tiles of each
+// alternative
+static void check_sets(const char *test, size_t round,
+    const struct acr_runtime_data *data_info,
+    const unsigned char *data,
+    struct acr_cloog_generation_buffer *buffer) {
+  acr_cloog_alternative_sets_from_monitor(data_info, data, 0, buffer);
+  for (size_t alt = 0; alt < NUM_ALTERNATIVES; ++alt) {
+    isl_set *expected = isl_set_copy(data_info->empty_monitor_set[0]);
+    for (size_t i = 0; i < data_info->monitor_total_size; ++i) {
+      if (alternative_from_val(data[i])->alternative_number == alt)
+        expected = isl_set_union(expected,
+            isl_set_copy(data_info->tiles_domains[0][i]));
+    }
+    check(isl_set_is_equal(buffer->sets[alt], expected) == isl_bool_true,
+        test, round, "not the union of the tiles");
+    isl_set_free(expected);
+    isl_set_free(buffer->sets[alt]);
+  }
+}
+
+static unsigned int seed = 12345;
+
+static unsigned char random_value(void) {
+  seed = seed * 1103515245u + 12345u;
+  return (unsigned char) ((seed >> 16) % (NUM_ALTERNATIVES + 1));
+}
+
+static void test_grid(isl_ctx *ctx, const char *test,
+    unsigned int num_dims, unsigned long *dim_max) {
+  struct acr_runtime_data data_info = grid_data(ctx, num_dims, dim_max);
+  const size_t size = data_info.monitor_total_size;
+  unsigned char *data = malloc(size * sizeof(*data));
+  struct acr_cloog_generation_buffer buffer;
+  acr_cloog_generation_buffer_init(&buffer, &data_info);
+
+  // A single alternative is a single box
+  memset(data, 1, size);
+  acr_cloog_alternative_sets_from_monitor(&data_info, data, 0, &buffer);
+  check(isl_set_n_basic_set(buffer.sets[1]) == 1, test, 0,
+      "a uniform grid is not a single box");
+  for (size_t alt = 0; alt < NUM_ALTERNATIVES; ++alt)
+    isl_set_free(buffer.sets[alt]);
+
+  for (size_t round = 0; round < num_rounds; ++round) {
+    if (round % 10 == 0) { // New grid, built from the rectangles
+      for (size_t i = 0; i < size; ++i)
+        data[i] = random_value();
+    } else { // A few tiles change, the previous sets are updated
+      const size_t num_changes = 1 + round % 3;
+      for (size_t i = 0; i < num_changes; ++i) {
+        seed = seed * 1103515245u + 12345u;
+        data[(seed >> 8) % size] = random_value();
+      }
+    }
+    check_sets(test, round, &data_info, data, &buffer);
+  }
+
+  acr_cloog_generation_buffer_free(&buffer, &data_info);
+  free(data);
+  free_grid_data(&data_info);
+}
+
+int main(void) {
+  for (size_t i = 0; i < NUM_ALTERNATIVES; ++i)
+    alternatives[i].alternative_number = i;
+
+  isl_ctx *ctx = isl_ctx_alloc();
+  unsigned long line[] = { 37 };
+  test_grid(ctx, "1 dimension", 1, line);
+  unsigned long plane[] = { 9, 11 };
+  test_grid(ctx, "2 dimensions", 2, plane);
+  unsigned long volume[] = { 3, 5, 6 };
+  test_grid(ctx, "3 dimensions", 3, volume);
+  isl_ctx_free(ctx);
+
+  if (num_errors > 0) {
+    fprintf(stderr, "%zu errors\n", num_errors);
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
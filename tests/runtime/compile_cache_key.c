@@ -0,0 +1,138 @@
+/*
+ * Copyright (C) 2016 Maxime Schmitt
+ *
+ * ACR is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+// A shared object of the disk cache must be reused for the same program and
+// options, and recompiled when the options or a header included with quotes
+// from a -I directory change, even through a nested include
+
+#include "acr/acr_runtime_build.h"
+
+#include <dlfcn.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+static const char program[] =
+  "#include \"key.h\"\n"
+  "int acr_cache_key(void) { return KEY_VALUE; }\n";
+
+static size_t num_errors = 0;
+static char cache_dir[] = "/tmp/acr_cache_key_XXXXXX";
+static char include_dir[] = "/tmp/acr_cache_key_include_XXXXXX";
+static char include_option[64];
+
+static void check(bool condition, const char *test, const char *message) {
+  if (!condition) {
+    fprintf(stderr, "%s: %s\n", test, message);
+    num_errors += 1;
+  }
+}
+
+static void write_header(const char *name, const char *content) {
+  char path[128];
+  snprintf(path, sizeof(path), "%s/%s", include_dir, name);
+  FILE *header = fopen(path, "w");
+  fputs(content, header);
+  fclose(header);
+}
+
+// Compile the program, check the value it returns and give the file name
+static char* compile(const char *test, const char *optimization,
+    int expected_value) {
+  size_t num_options = 2;
+  char **options = malloc(num_options * sizeof(*options));
+  options[0] = (char *) optimization;
+  options[1] = include_option;
+  acr_append_necessary_compile_flags(&num_options, &options);
+  bool in_cache;
+  char *filename = acr_compile_with_system_compiler_cached(NULL, cache_dir,
+      program, num_options, options, &in_cache);
+  free(options);
+  if (filename == NULL) {
+    check(false, test, "compilation failed");
+    return NULL;
+  }
+  check(in_cache, test, "not compiled in the cache");
+  check(strncmp(filename, cache_dir, strlen(cache_dir)) == 0, test,
+      "the file is not in the cache directory");
+  void *handle = dlopen(filename, RTLD_NOW | RTLD_LOCAL);
+  if (handle == NULL) {
+    check(false, test, dlerror());
+    return filename;
+  }
+  int (*key)(void) = (int (*)(void)) dlsym(handle, "acr_cache_key");
+  check(key != NULL && key() == expected_value, test, "wrong value");
+  dlclose(handle);
+  return filename;
+}
+
+static void remove_directory_files(const char *directory) {
+  char command[128];
+  snprintf(command, sizeof(command), "rm -rf %s", directory);
+  if (system(command) != 0)
+    fprintf(stderr, "Could not remove %s\n", directory);
+}
+
+int main(void) {
+  if (mkdtemp(cache_dir) == NULL || mkdtemp(include_dir) == NULL) {
+    perror("mkdtemp");
+    return EXIT_FAILURE;
+  }
+  snprintf(include_option, sizeof(include_option), "-I%s", include_dir);
+  write_header("key.h", "#include \"value.h\"\n#define KEY_VALUE VALUE\n");
+  write_header("value.h", "#define VALUE 1\n");
+
+  char *first = compile("first", "-O0", 1);
+  char *again = compile("same program", "-O0", 1);
+  check(first && again && strcmp(first, again) == 0, "same program",
+      "compiled to an other file");
+  char *other_options = compile("other options", "-O1", 1);
+  check(first && other_options && strcmp(first, other_options) != 0,
+      "other options", "the key ignores the options");
+
+  write_header("value.h", "#define VALUE 2\n");
+  char *nested_edit = compile("nested header edit", "-O0", 2);
+  check(first && nested_edit && strcmp(first, nested_edit) != 0,
+      "nested header edit", "the key ignores the nested header");
+
+  write_header("key.h", "#include \"value.h\"\n#define KEY_VALUE (VALUE+1)\n");
+  char *edit = compile("header edit", "-O0", 3);
+  check(nested_edit && edit && strcmp(nested_edit, edit) != 0,
+      "header edit", "the key ignores the header");
+
+  // Back to the first headers, the first object is reused
+  write_header("key.h", "#include \"value.h\"\n#define KEY_VALUE VALUE\n");
+  write_header("value.h", "#define VALUE 1\n");
+  char *restored = compile("restored header", "-O0", 1);
+  check(first && restored && strcmp(first, restored) == 0,
+      "restored header", "the first object is not reused");
+
+  free(first);
+  free(again);
+  free(other_options);
+  free(nested_edit);
+  free(edit);
+  free(restored);
+  remove_directory_files(cache_dir);
+  remove_directory_files(include_dir);
+  if (num_errors > 0) {
+    fprintf(stderr, "%zu errors\n", num_errors);
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,141 @@
+/*
+ * Copyright (C) 2016 Maxime Schmitt
+ *
+ * ACR is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+// The coordinator keeps the pool under pressure: the kernel switches between
+// versions while new ones are generated in the other slots. The slots used by
+// or proposed to the kernel must never be chosen, the least recently used
+// reusable slot must be, and the pool grows only when nothing can be reused.
+
+#include "acr/acr_runtime_function_pool.h"
+
+#include <stdio.h>
+
+#define max_slots 8
+
+static const size_t initial_slots = 3;
+static const size_t num_rounds = 10000;
+
+static size_t num_errors = 0;
+
+// What each slot holds, as seen by the test
+static size_t content[max_slots];
+static bool busy[max_slots];
+
+static bool reusable(size_t slot, void *user_data) {
+  (void) user_data;
+  return !busy[slot];
+}
+
+static void check(bool condition, const char *message, size_t round) {
+  if (!condition) {
+    fprintf(stderr, "Round %zu: %s\n", round, message);
+    num_errors += 1;
+  }
+}
+
+static size_t oldest_reusable(const struct acr_function_pool *pool,
+    size_t used, size_t proposed) {
+  size_t oldest = pool->num_slots;
+  for (size_t i = 0; i < pool->num_slots; ++i) {
+    if (i == used || i == proposed || busy[i])
+      continue;
+    if (oldest == pool->num_slots || pool->last_used[i] < pool->last_used[oldest])
+      oldest = i;
+  }
+  return oldest;
+}
+
+static void test_pressure(void) {
+  struct acr_function_pool pool;
+  acr_function_pool_init(&pool, initial_slots, max_slots);
+  size_t used = 0, proposed = 1;
+  size_t next_content = 1;
+  content[used] = next_content++;
+  content[proposed] = next_content++;
+  acr_function_pool_touch(&pool, used);
+
+  unsigned int seed = 12345;
+  for (size_t round = 0; round < num_rounds; ++round) {
+    seed = seed * 1103515245u + 12345u;
+    // Some slots are being generated or compiled
+    for (size_t i = 0; i < pool.num_slots; ++i)
+      busy[i] = ((seed >> (i + 8)) & 3u) == 0;
+    const size_t used_content = content[used];
+    const size_t proposed_content = content[proposed];
+    const size_t expected = oldest_reusable(&pool, used, proposed);
+    const size_t num_slots = pool.num_slots;
+
+    size_t chosen =
+      acr_function_pool_choose_slot(&pool, used, proposed, reusable, NULL);
+    check(chosen == expected, "not the least recently used slot", round);
+    if (chosen == pool.num_slots) {
+      check(expected == num_slots, "a reusable slot was missed", round);
+      if (acr_function_pool_grow(&pool)) {
+        check(pool.num_slots == num_slots + 1, "wrong growth", round);
+        busy[num_slots] = false;
+        chosen = acr_function_pool_choose_slot(&pool, used, proposed,
+            reusable, NULL);
+        check(chosen == num_slots, "the new slot is not chosen", round);
+      } else {
+        check(num_slots == max_slots, "the pool did not grow", round);
+        continue;
+      }
+    }
+    check(chosen != used, "the slot of the kernel is reused", round);
+    check(chosen != proposed, "the proposed slot is reused", round);
+    check(!busy[chosen], "a busy slot is reused", round);
+    content[chosen] = next_content++;
+
+    // The kernel still finds its versions at the same indices
+    check(content[used] == used_content, "the kernel slot moved", round);
+    check(content[proposed] == proposed_content, "the proposed slot moved",
+        round);
+
+    // The kernel takes the proposed version, the new one is proposed
+    if (seed & 1u) {
+      used = proposed;
+      acr_function_pool_touch(&pool, used);
+      proposed = chosen;
+    }
+  }
+  check(pool.num_slots == max_slots, "the pool never reached its size",
+      num_rounds);
+  acr_function_pool_free(&pool);
+}
+
+// Nothing reusable and no room left
+static void test_full(void) {
+  struct acr_function_pool pool;
+  acr_function_pool_init(&pool, 2, 2);
+  for (size_t i = 0; i < 2; ++i)
+    busy[i] = false;
+  check(acr_function_pool_choose_slot(&pool, 0, 1, reusable, NULL) == 2,
+      "a used slot was chosen in a full pool", 0);
+  check(!acr_function_pool_grow(&pool), "the pool grew over its maximum", 0);
+  acr_function_pool_free(&pool);
+}
+
+int main(void) {
+  test_pressure();
+  test_full();
+  if (num_errors > 0) {
+    fprintf(stderr, "%zu errors\n", num_errors);
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
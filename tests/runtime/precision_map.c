@@ -0,0 +1,165 @@
+/*
+ * Copyright (C) 2016 Maxime Schmitt
+ *
+ * ACR is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+// A precision map saved by free_acr_static_data must be reloaded as is by a
+// kernel with the same grid, and ignored by any other kernel or when the file
+// is damaged
+
+#include "acr/acr_runtime_data.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static const char kernel_name[] = "precision_map_test";
+static const size_t num_dims = 2;
+
+static size_t num_errors = 0;
+static char map_path[64];
+
+// Initialize the grid like the generated code of a static kernel does
+static struct acr_runtime_data_static kernel(size_t num_alternatives,
+    size_t grid_size, intmax_t max) {
+  struct acr_runtime_data_static static_data = {
+    .is_uninitialized = true,
+    .name = kernel_name,
+    .num_alternatives = num_alternatives,
+    .total_functions = 0,
+    .min_max = NULL,
+    .tile_origins = NULL,
+    .tile_order = NULL,
+    .wavefront_start = NULL,
+    .num_wavefronts = 0,
+    .num_monitor_dimensions = num_dims,
+    .grid_size = grid_size,
+  };
+  static_data.min_max = malloc(num_dims * sizeof(*static_data.min_max));
+  for (size_t i = 0; i < num_dims; ++i) {
+    static_data.min_max[i][0] = 0;
+    static_data.min_max[i][1] = max;
+  }
+  acr_static_data_init_grid(&static_data);
+  static_data.is_uninitialized = 0;
+  return static_data;
+}
+
+// Free without saving the map
+static void drop(struct acr_runtime_data_static *static_data) {
+  static_data->is_uninitialized = 1;
+  free_acr_static_data(static_data);
+}
+
+static unsigned char saved_precision(size_t i, size_t num_alternatives) {
+  return (unsigned char) ((i * 7 + 3) % num_alternatives);
+}
+
+static void expect_initial(const char *test,
+    const struct acr_runtime_data_static *static_data) {
+  for (size_t i = 0; i < static_data->total_functions; ++i) {
+    if (static_data->precision_array[i] != 0) {
+      fprintf(stderr, "%s: the map was used\n", test);
+      num_errors += 1;
+      return;
+    }
+  }
+}
+
+// Overwrite the saved file at offset, counted from the end if negative, or
+// append to it, check that the map is ignored and restore the file
+static void test_damaged_file(const char *test, long offset,
+    const void *bytes, size_t num_bytes, bool append) {
+  FILE *map_file = fopen(map_path, "rb");
+  fseek(map_file, 0l, SEEK_END);
+  const size_t size = (size_t) ftell(map_file);
+  unsigned char *original = malloc(size);
+  rewind(map_file);
+  if (fread(original, 1, size, map_file) != size)
+    perror("fread");
+  fclose(map_file);
+
+  map_file = fopen(map_path, append ? "ab" : "r+b");
+  if (!append)
+    fseek(map_file, offset, offset < 0 ? SEEK_END : SEEK_SET);
+  fwrite(bytes, 1, num_bytes, map_file);
+  fclose(map_file);
+  struct acr_runtime_data_static static_data = kernel(4, 4, 16);
+  expect_initial(test, &static_data);
+  drop(&static_data);
+
+  map_file = fopen(map_path, "wb");
+  fwrite(original, 1, size, map_file);
+  fclose(map_file);
+  free(original);
+}
+
+int main(void) {
+  char map_dir[] = "/tmp/acr_precision_map_XXXXXX";
+  if (mkdtemp(map_dir) == NULL) {
+    perror("mkdtemp");
+    return EXIT_FAILURE;
+  }
+  setenv("ACR_PRECISION_MAP_DIR", map_dir, 1);
+  snprintf(map_path, sizeof(map_path), "%s/%s.precision", map_dir,
+      kernel_name);
+
+  // No map yet
+  struct acr_runtime_data_static first = kernel(4, 4, 16);
+  expect_initial("no map", &first);
+  for (size_t i = 0; i < first.total_functions; ++i)
+    first.precision_array[i] = saved_precision(i, 4);
+  free_acr_static_data(&first);
+  if (access(map_path, R_OK) != 0) {
+    fprintf(stderr, "round trip: the map was not saved\n");
+    return EXIT_FAILURE;
+  }
+
+  struct acr_runtime_data_static second = kernel(4, 4, 16);
+  for (size_t i = 0; i < second.total_functions; ++i) {
+    if (second.precision_array[i] != saved_precision(i, 4)) {
+      fprintf(stderr, "round trip: precision %zu is %u instead of %u\n", i,
+          second.precision_array[i], saved_precision(i, 4));
+      num_errors += 1;
+      break;
+    }
+  }
+  drop(&second);
+
+  struct acr_runtime_data_static other_alternatives = kernel(5, 4, 16);
+  expect_initial("other number of alternatives", &other_alternatives);
+  drop(&other_alternatives);
+  struct acr_runtime_data_static other_grid = kernel(4, 8, 16);
+  expect_initial("other grid size", &other_grid);
+  drop(&other_grid);
+  struct acr_runtime_data_static other_bounds = kernel(4, 4, 20);
+  expect_initial("other kernel bounds", &other_bounds);
+  drop(&other_bounds);
+
+  test_damaged_file("bad magic", 0l, "X", 1, false);
+  const unsigned char bad_precision = 4;
+  test_damaged_file("bad precision", -1l, &bad_precision, 1, false);
+  test_damaged_file("trailing data", 0l, "X", 1, true);
+
+  unlink(map_path);
+  rmdir(map_dir);
+  if (num_errors > 0) {
+    fprintf(stderr, "%zu errors\n", num_errors);
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,163 @@
+/*
+ * Copyright (C) 2016 Maxime Schmitt
+ *
+ * ACR is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+// Several producers and consumers share a small queue so that it is often
+// full and empty. Every element must be taken exactly once, and a consumer
+// must see the elements of one producer in the order they were pushed.
+
+#include "acr/acr_runtime_queue.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define num_producers 4
+#define num_consumers 4
+
+static const size_t queue_capacity = 16;
+static const size_t items_per_producer = 100000;
+static const size_t max_batch = 5;
+
+static struct acr_queue queue;
+static atomic_uint *times_taken;
+static atomic_size_t num_taken;
+static atomic_size_t num_errors;
+
+// Element 0 would be a NULL pointer, items start at 1
+static void* item_of(size_t producer, size_t i) {
+  return (void *) (uintptr_t) (producer * items_per_producer + i + 1);
+}
+
+static void* producer(void *in_data) {
+  const size_t producer = (size_t) (uintptr_t) in_data;
+  for (size_t i = 0; i < items_per_producer; ++i) {
+    while (!acr_queue_push(&queue, item_of(producer, i)))
+      sched_yield();
+  }
+  return NULL;
+}
+
+static void* consumer(void *in_data) {
+  (void) in_data;
+  const size_t total = num_producers * items_per_producer;
+  size_t last_seen[num_producers] = {0};
+  void *items[max_batch];
+  size_t num_items;
+  while ((num_items = acr_queue_pop_wait(&queue, items, max_batch)) > 0) {
+    for (size_t i = 0; i < num_items; ++i) {
+      const size_t item = (size_t) (uintptr_t) items[i];
+      if (item == 0 || item > total) {
+        fprintf(stderr, "Unknown element %zu\n", item);
+        atomic_fetch_add(&num_errors, 1);
+        continue;
+      }
+      const size_t from = (item - 1) / items_per_producer;
+      if (item <= last_seen[from]) {
+        fprintf(stderr, "Element %zu taken after %zu\n", item,
+            last_seen[from]);
+        atomic_fetch_add(&num_errors, 1);
+      }
+      last_seen[from] = item;
+      atomic_fetch_add(&times_taken[item - 1], 1);
+    }
+    // The consumer taking the last element stops the others
+    if (atomic_fetch_add(&num_taken, num_items) + num_items == total)
+      acr_queue_close(&queue);
+  }
+  return NULL;
+}
+
+// Single thread: the queue holds exactly its rounded up capacity, in order
+static void test_bounds(void) {
+  struct acr_queue small;
+  acr_queue_init(&small, 5);
+  const size_t num_cells = small.mask + 1;
+  for (size_t round = 0; round < 3; ++round) {
+    for (size_t i = 0; i < num_cells; ++i) {
+      if (!acr_queue_push(&small, item_of(0, i))) {
+        fprintf(stderr, "Push %zu refused in a non full queue\n", i);
+        atomic_fetch_add(&num_errors, 1);
+      }
+    }
+    if (acr_queue_push(&small, item_of(0, num_cells))) {
+      fprintf(stderr, "Push accepted in a full queue\n");
+      atomic_fetch_add(&num_errors, 1);
+    }
+    void *item;
+    for (size_t i = 0; i < num_cells; ++i) {
+      if (!acr_queue_try_pop(&small, &item) || item != item_of(0, i)) {
+        fprintf(stderr, "Element %zu not taken in order\n", i);
+        atomic_fetch_add(&num_errors, 1);
+      }
+    }
+    if (acr_queue_try_pop(&small, &item)) {
+      fprintf(stderr, "Pop succeeded on an empty queue\n");
+      atomic_fetch_add(&num_errors, 1);
+    }
+  }
+  acr_queue_close(&small);
+  void *item;
+  if (acr_queue_pop_wait(&small, &item, 1) != 0) {
+    fprintf(stderr, "Pop succeeded on a closed queue\n");
+    atomic_fetch_add(&num_errors, 1);
+  }
+  acr_queue_free(&small);
+}
+
+static void test_stress(void) {
+  const size_t total = num_producers * items_per_producer;
+  times_taken = malloc(total * sizeof(*times_taken));
+  for (size_t i = 0; i < total; ++i)
+    atomic_init(&times_taken[i], 0);
+  atomic_init(&num_taken, 0);
+  acr_queue_init(&queue, queue_capacity);
+
+  pthread_t consumers[num_consumers];
+  pthread_t producers[num_producers];
+  for (size_t i = 0; i < num_consumers; ++i)
+    pthread_create(&consumers[i], NULL, consumer, NULL);
+  for (size_t i = 0; i < num_producers; ++i)
+    pthread_create(&producers[i], NULL, producer, (void *) (uintptr_t) i);
+  for (size_t i = 0; i < num_producers; ++i)
+    pthread_join(producers[i], NULL);
+  for (size_t i = 0; i < num_consumers; ++i)
+    pthread_join(consumers[i], NULL);
+
+  for (size_t i = 0; i < total; ++i) {
+    const unsigned int taken = atomic_load(&times_taken[i]);
+    if (taken != 1) {
+      fprintf(stderr, "Element %zu taken %u times\n", i + 1, taken);
+      atomic_fetch_add(&num_errors, 1);
+    }
+  }
+  acr_queue_free(&queue);
+  free(times_taken);
+}
+
+int main(void) {
+  atomic_init(&num_errors, 0);
+  test_bounds();
+  test_stress();
+  const size_t errors = atomic_load(&num_errors);
+  if (errors > 0) {
+    fprintf(stderr, "%zu errors\n", errors);
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,111 @@
+/*
+ * Copyright (C) 2016 Maxime Schmitt
+ *
+ * ACR is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+// The tiles of a static kernel may only run in parallel when no two tiles
+// touch the same element, and by wavefront when the tiles a tile depends on
+// are all on previous diagonals. Anything else keeps the sequential order.
+
+#include "acr/acr_openscop.h"
+
+#include <clan/scop.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+static const size_t grid_size = 4;
+
+static size_t num_errors = 0;
+
+static const char* schedule_name(enum acr_tile_schedule schedule) {
+  switch (schedule) {
+    case acr_tile_schedule_sequential:
+      return "sequential";
+    case acr_tile_schedule_parallel:
+      return "parallel";
+    case acr_tile_schedule_wavefront:
+      return "wavefront";
+  }
+  return "unknown";
+}
+
+static osl_scop_p extract_scop(const char *code) {
+  FILE *input = tmpfile();
+  fputs(code, input);
+  rewind(input);
+  char name[] = "tile_schedule.c";
+  clan_options_t clan_options;
+  clan_options.autoscop = 0;
+  clan_options.bounded_context = 0;
+  clan_options.castle = 0;
+  clan_options.extbody = 0;
+  clan_options.inputscop = 0;
+  clan_options.name = name;
+  clan_options.noloopcontext = 0;
+  clan_options.nosimplify = 0;
+  clan_options.outscoplib = 0;
+  clan_options.precision = 0;
+  clan_options.structure = 0;
+  osl_scop_p scop = clan_scop_extract(input, &clan_options);
+  fclose(input);
+  return scop;
+}
+
+// The monitored dimensions are i and j, below the time loop t
+static void check_schedule(const char *test, const char *statement,
+    enum acr_tile_schedule expected) {
+  char code[512];
+  snprintf(code, sizeof(code),
+      "#pragma scop\n"
+      "for (t = 0; t < 8; ++t)\n"
+      "  for (i = 1; i < 15; ++i)\n"
+      "    for (j = 1; j < 15; ++j)\n"
+      "      %s\n"
+      "#pragma endscop\n", statement);
+  osl_scop_p scop = extract_scop(code);
+  if (scop == NULL) {
+    fprintf(stderr, "%s: no scop extracted\n", test);
+    num_errors += 1;
+    return;
+  }
+  const enum acr_tile_schedule schedule =
+    acr_osl_get_tile_schedule(scop, 1, 2, grid_size);
+  if (schedule != expected) {
+    fprintf(stderr, "%s: %s schedule instead of %s\n", test,
+        schedule_name(schedule), schedule_name(expected));
+    num_errors += 1;
+  }
+  osl_scop_free(scop);
+}
+
+int main(void) {
+  check_schedule("pointwise", "b[i][j] = a[i][j] + b[i][j];",
+      acr_tile_schedule_parallel);
+  check_schedule("upper and left neighbours",
+      "a[i][j] = a[i-1][j] + a[i][j-1];",
+      acr_tile_schedule_wavefront);
+  check_schedule("upper right neighbour", "a[i][j] = a[i-1][j+1];",
+      acr_tile_schedule_sequential);
+  check_schedule("mirrored rows", "a[i][j] = a[15-i][j];",
+      acr_tile_schedule_wavefront);
+  check_schedule("mirrored grid", "a[i][j] = a[15-i][15-j];",
+      acr_tile_schedule_sequential);
+  if (num_errors > 0) {
+    fprintf(stderr, "%zu errors\n", num_errors);
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
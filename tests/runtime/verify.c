@@ -0,0 +1,164 @@
+/*
+ * Copyright (C) 2016 Maxime Schmitt
+ *
+ * ACR is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+// Every verification implementation supported by the processor must give the
+// same results as the scalar one, for any length of grid
+
+#include "acr/acr_runtime_verify.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+static const char *const implementation_names[acr_verify_num_implementations] = {
+  [acr_verify_implementation_scalar] = "scalar",
+  [acr_verify_implementation_sse41] = "sse4.1",
+  [acr_verify_implementation_avx2] = "avx2",
+  [acr_verify_implementation_avx512] = "avx512",
+};
+
+// Longer than three 64 bytes vectors to go through every tail length
+static const size_t max_length = 200;
+
+static uint64_t random_state = 88172645463325252u;
+
+static unsigned char random_byte(unsigned int bound) {
+  random_state ^= random_state << 13;
+  random_state ^= random_state >> 7;
+  random_state ^= random_state << 17;
+  return (unsigned char) (random_state % bound);
+}
+
+static size_t num_errors = 0;
+
+static void report(const char *function, enum acr_verify_implementation
+    implementation, size_t isize, size_t jsize) {
+  fprintf(stderr, "%s differs from scalar with %s (%zu x %zu)\n",
+      function, implementation_names[implementation], isize, jsize);
+  num_errors += 1;
+}
+
+static void test_verify_me(enum acr_verify_implementation implementation,
+    size_t length, unsigned char *current, unsigned char *more_recent) {
+  for (size_t i = 0; i < length; ++i) {
+    more_recent[i] = random_byte(256);
+    current[i] = (unsigned char) (more_recent[i] - random_byte(more_recent[i] + 1u));
+  }
+  // A single failing position, anywhere including the tail
+  if (length > 0 && random_byte(2)) {
+    const size_t position = random_state % length;
+    more_recent[position] = random_byte(255);
+    current[position] = (unsigned char) (more_recent[position] + 1);
+  }
+  acr_verify_use_implementation(acr_verify_implementation_scalar);
+  const bool expected = acr_verify_me(length, current, more_recent);
+  acr_verify_use_implementation(implementation);
+  if (acr_verify_me(length, current, more_recent) != expected)
+    report("acr_verify_me", implementation, 1, length);
+}
+
+static void test_verify_versioning(
+    enum acr_verify_implementation implementation, size_t length,
+    unsigned char *current, unsigned char *more_recent,
+    unsigned char *expected_version, unsigned char *version) {
+  for (size_t i = 0; i < length; ++i) {
+    current[i] = random_byte(256);
+    more_recent[i] = random_byte(4) ? current[i] : random_byte(256);
+  }
+  double expected_delta, delta;
+  bool expected_valid, valid;
+  acr_verify_use_implementation(acr_verify_implementation_scalar);
+  acr_verify_versioning(length, current, more_recent, expected_version, 256,
+      &expected_delta, &expected_valid);
+  acr_verify_use_implementation(implementation);
+  acr_verify_versioning(length, current, more_recent, version, 256,
+      &delta, &valid);
+  // Every implementation divides the same integer sum, the results must be
+  // bit identical
+  if (valid != expected_valid ||
+      (length > 0 && memcmp(&delta, &expected_delta, sizeof(delta)) != 0) ||
+      memcmp(version, expected_version, length) != 0)
+    report("acr_verify_versioning", implementation, 1, length);
+}
+
+static void test_verify_2dstencil(
+    enum acr_verify_implementation implementation,
+    size_t isize, size_t jsize, unsigned char max_alt,
+    unsigned char *current, unsigned char *more_recent,
+    unsigned char *expected_version, unsigned char *version) {
+  const size_t length = isize * jsize;
+  for (size_t i = 0; i < length; ++i) {
+    more_recent[i] = random_byte(max_alt + 1u);
+    current[i] = random_byte(max_alt + 1u);
+  }
+  const unsigned long dims[2] = {isize, jsize};
+  bool expected_required, required, expected_valid, valid;
+  acr_verify_use_implementation(acr_verify_implementation_scalar);
+  acr_verify_2dstencil(max_alt, dims, more_recent, current, expected_version,
+      &expected_required, &expected_valid);
+  acr_verify_use_implementation(implementation);
+  acr_verify_2dstencil(max_alt, dims, more_recent, current, version,
+      &required, &valid);
+  if (valid != expected_valid || required != expected_required ||
+      memcmp(version, expected_version, length) != 0)
+    report("acr_verify_2dstencil", implementation, isize, jsize);
+}
+
+int main(void) {
+  const size_t max_stencil_rows = 5;
+  unsigned char *current = malloc(max_stencil_rows * max_length);
+  unsigned char *more_recent = malloc(max_stencil_rows * max_length);
+  unsigned char *expected_version = malloc(max_stencil_rows * max_length);
+  unsigned char *version = malloc(max_stencil_rows * max_length);
+  static const unsigned char max_alts[] = {1, 2, 3, 5, 127, 128, 254};
+
+  for (size_t impl = 0; impl < acr_verify_num_implementations; ++impl) {
+    const enum acr_verify_implementation implementation =
+      (enum acr_verify_implementation) impl;
+    if (!acr_verify_use_implementation(implementation)) {
+      printf("%s: not supported, skipped\n",
+          implementation_names[implementation]);
+      continue;
+    }
+    for (size_t length = 0; length <= max_length; ++length) {
+      for (size_t repeat = 0; repeat < 8; ++repeat) {
+        test_verify_me(implementation, length, current, more_recent);
+        test_verify_versioning(implementation, length, current, more_recent,
+            expected_version, version);
+      }
+      for (size_t isize = 1; length > 0 && isize <= max_stencil_rows;
+          ++isize) {
+        for (size_t k = 0; k < sizeof(max_alts); ++k) {
+          test_verify_2dstencil(implementation, isize, length, max_alts[k],
+              current, more_recent, expected_version, version);
+        }
+      }
+    }
+    printf("%s: tested\n", implementation_names[implementation]);
+  }
+
+  free(current);
+  free(more_recent);
+  free(expected_version);
+  free(version);
+  if (num_errors > 0) {
+    fprintf(stderr, "%zu errors\n", num_errors);
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
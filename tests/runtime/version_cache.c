@@ -0,0 +1,203 @@
+/*
+ * Copyright (C) 2016 Maxime Schmitt
+ *
+ * ACR is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+// The version cache must give back the version of any grid with the same
+// alternatives, evict the least recently used entry without user when full,
+// never evict an entry in use, and own the code given to it exactly once
+
+#include "acr/acr_runtime_cache.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define monitor_size 4
+
+static const size_t capacity = 3;
+
+static size_t num_errors = 0;
+static size_t num_unloaded = 0;
+
+// Values 0 and 1 use alternative 0, 2 uses alternative 1, 3 has none
+static unsigned char value_keys[UCHAR_MAX + 1];
+
+static void check(bool condition, const char *test, const char *message) {
+  if (!condition) {
+    fprintf(stderr, "%s: %s\n", test, message);
+    num_errors += 1;
+  }
+}
+
+static void count_unload(void *code_handle) {
+  (void) code_handle;
+  num_unloaded += 1;
+}
+
+static void grid(unsigned char result[monitor_size], unsigned char value) {
+  memset(result, 0, monitor_size);
+  result[monitor_size - 1] = value;
+}
+
+static void init_cache(struct acr_version_cache *cache) {
+  memset(value_keys, ACR_VERSION_CACHE_NO_ALTERNATIVE, sizeof(value_keys));
+  value_keys[0] = 0;
+  value_keys[1] = 0;
+  value_keys[2] = 1;
+  acr_version_cache_init(cache, capacity, monitor_size, value_keys);
+}
+
+static void test_same_alternatives(void) {
+  struct acr_version_cache cache;
+  init_cache(&cache);
+  unsigned char result[monitor_size];
+  grid(result, 0);
+  check(acr_version_cache_acquire(&cache, result) == NULL,
+      "same alternatives", "found in an empty cache");
+  struct acr_version_cache_entry *entry =
+    acr_version_cache_insert(&cache, result, "code");
+  check(entry != NULL, "same alternatives", "not inserted");
+  acr_version_cache_release(&cache, entry);
+
+  grid(result, 1);
+  struct acr_version_cache_entry *same =
+    acr_version_cache_acquire(&cache, result);
+  check(same == entry, "same alternatives", "value 1 has an other version");
+  check(same && strcmp(same->generated_code, "code") == 0,
+      "same alternatives", "wrong generated code");
+  acr_version_cache_release(&cache, same);
+
+  grid(result, 2);
+  check(acr_version_cache_acquire(&cache, result) == NULL,
+      "same alternatives", "value 2 shares the version of value 0");
+  grid(result, 3);
+  check(acr_version_cache_acquire(&cache, result) == NULL,
+      "same alternatives", "value 3 shares the version of value 0");
+  acr_version_cache_free(&cache);
+}
+
+// Each grid differs by the alternative of one tile
+static void key_grid(unsigned char result[monitor_size], size_t i) {
+  for (size_t j = 0; j < monitor_size; ++j)
+    result[j] = (i >> j) & 1u ? 2 : 0;
+}
+
+static void test_lru_eviction(void) {
+  struct acr_version_cache cache;
+  init_cache(&cache);
+  unsigned char result[monitor_size];
+  struct acr_version_cache_entry *entries[4];
+  for (size_t i = 0; i < capacity; ++i) {
+    key_grid(result, i);
+    entries[i] = acr_version_cache_insert(&cache, result, "code");
+    acr_version_cache_set_function(&cache, entries[i], acr_version_tier_quick,
+        &entries[i], count_unload, &entries[i]);
+    acr_version_cache_release(&cache, entries[i]);
+  }
+  // Grid 0 becomes the most recently used, grid 1 is the least recently used
+  key_grid(result, 0);
+  acr_version_cache_release(&cache, acr_version_cache_acquire(&cache, result));
+
+  key_grid(result, 3);
+  num_unloaded = 0;
+  entries[3] = acr_version_cache_insert(&cache, result, "code");
+  check(entries[3] == entries[1], "lru eviction", "wrong entry evicted");
+  check(num_unloaded == 1, "lru eviction", "evicted code not unloaded");
+  check(acr_version_cache_get_function(&cache, entries[3],
+        acr_version_tier_quick) == NULL,
+      "lru eviction", "the new entry has the evicted function");
+  acr_version_cache_release(&cache, entries[3]);
+  key_grid(result, 1);
+  check(acr_version_cache_acquire(&cache, result) == NULL,
+      "lru eviction", "grid 1 still cached");
+  key_grid(result, 0);
+  struct acr_version_cache_entry *kept =
+    acr_version_cache_acquire(&cache, result);
+  check(kept == entries[0], "lru eviction", "grid 0 evicted");
+  check(acr_version_cache_get_function(&cache, kept, acr_version_tier_quick)
+      == &entries[0], "lru eviction", "grid 0 lost its function");
+  acr_version_cache_release(&cache, kept);
+
+  num_unloaded = 0;
+  acr_version_cache_free(&cache);
+  check(num_unloaded == 2, "lru eviction", "code not unloaded by free");
+}
+
+static void test_in_use(void) {
+  struct acr_version_cache cache;
+  init_cache(&cache);
+  unsigned char result[monitor_size];
+  struct acr_version_cache_entry *entries[4];
+  for (size_t i = 0; i < capacity; ++i) {
+    key_grid(result, i);
+    entries[i] = acr_version_cache_insert(&cache, result, "code");
+  }
+  // Every entry is in use, the oldest one included
+  key_grid(result, 3);
+  check(acr_version_cache_insert(&cache, result, "code") == NULL,
+      "in use", "an entry in use was evicted");
+
+  // Only grid 2, the most recent, is free
+  acr_version_cache_release(&cache, entries[2]);
+  entries[3] = acr_version_cache_insert(&cache, result, "code");
+  check(entries[3] == entries[2], "in use", "an entry in use was evicted");
+  for (size_t i = 0; i < 2; ++i) {
+    key_grid(result, i);
+    struct acr_version_cache_entry *entry =
+      acr_version_cache_acquire(&cache, result);
+    check(entry == entries[i], "in use", "an entry in use was lost");
+    acr_version_cache_release(&cache, entry);
+    acr_version_cache_release(&cache, entries[i]);
+  }
+  acr_version_cache_release(&cache, entries[3]);
+  acr_version_cache_free(&cache);
+}
+
+static void test_set_function_twice(void) {
+  struct acr_version_cache cache;
+  init_cache(&cache);
+  unsigned char result[monitor_size];
+  grid(result, 2);
+  struct acr_version_cache_entry *entry =
+    acr_version_cache_insert(&cache, result, "code");
+  int first, second;
+  num_unloaded = 0;
+  void *function = acr_version_cache_set_function(&cache, entry,
+      acr_version_tier_optimized, &first, count_unload, &first);
+  check(function == &first, "set twice", "first function not used");
+  function = acr_version_cache_set_function(&cache, entry,
+      acr_version_tier_optimized, &second, count_unload, &second);
+  check(function == &first, "set twice", "second function used");
+  check(num_unloaded == 1, "set twice", "second code not unloaded");
+  check(acr_version_cache_get_function(&cache, entry,
+        acr_version_tier_quick) == NULL,
+      "set twice", "the quick tier is set");
+  acr_version_cache_release(&cache, entry);
+  acr_version_cache_free(&cache);
+  check(num_unloaded == 2, "set twice", "first code not unloaded by free");
+}
+
+int main(void) {
+  test_same_alternatives();
+  test_lru_eviction();
+  test_in_use();
+  test_set_function_twice();
+  if (num_errors > 0) {
+    fprintf(stderr, "%zu errors\n", num_errors);
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}